@@ -0,0 +1,462 @@
+// Micro-benchmarks for the simulation and render hot paths.
+//
+// Every benchmark is warmed up, then timed over a number of repetitions; each repetition runs
+// the body enough times to take about a millisecond, so timer resolution doesn't matter.
+// Results are per call, as the median and p99 over repetitions, printed as a table or as JSON.
+//
+//   snake_bench [--filter TEXT] [--repetitions N] [--warmup-ms N] [--json FILE|-]
+//
+// With --check-allocations it runs no benchmarks, and instead checks that simulation ticks and
+// render frames make no heap allocations once warmed up (needs SNAKE_ALLOC_TRACKING). It exits
+// with 1 if they do, so it can gate a build.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../include/alloc_tracker.hpp"
+#include "../include/cell_mesh.hpp"
+#include "../include/food.hpp"
+#include "../include/game_world.hpp"
+#include "../include/header.hpp"
+#include "../include/render_queue.hpp"
+#include "../include/shader.hpp"
+#include "../include/simulation.hpp"
+#include "../include/snake.hpp"
+#include "../include/terminal_renderer.hpp"
+#include "../include/timing_histogram.hpp"
+
+#ifdef SNAKE_HEADLESS
+#include "../include/headless_surface.hpp"
+#endif
+
+using BenchClock = std::chrono::steady_clock;
+
+// Keeps the compiler from optimizing away a result that is otherwise unused
+template <typename T>
+static void keep(const T& value)
+{
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct BenchOptions
+{
+  std::string filter;
+  GLuint repetitions{50};
+  GLuint warmupMs{50};
+  std::string jsonPath;
+  bool checkAllocations{false};
+};
+
+struct BenchResult
+{
+  std::string name;
+  GLuint length{0};  // snake segments, 0 = not a parameter
+  GLuint grid{0};    // grid base size, 0 = not a parameter
+  size_t iterations{0};
+  double median{0}, p99{0}, mean{0};  // nanoseconds per call
+};
+
+class Bench
+{
+ public:
+  explicit Bench(const BenchOptions& options) : options(options) {}
+
+  /**
+   * Times a benchmark body, unless the filter leaves it out.
+   * @param name Benchmark name, e.g. "snake/step".
+   * @param length Snake length it runs with, or 0.
+   * @param grid Grid base size it runs with, or 0.
+   * @param body Runs one call of the code being measured.
+   */
+  void run(const std::string& name, GLuint length, GLuint grid, const std::function<void()>& body)
+  {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+
+    // Warm up caches, branch predictors and the driver, and find how many calls take about 1 ms
+    size_t batch{1};
+    const auto warmupEnd{BenchClock::now() + std::chrono::milliseconds(options.warmupMs)};
+    do
+    {
+      const auto start{BenchClock::now()};
+      for (size_t i{0}; i < batch; ++i) body();
+      if (BenchClock::now() - start < std::chrono::milliseconds(1)) batch *= 2;
+    } while (BenchClock::now() < warmupEnd);
+
+    std::vector<double> samples;
+    samples.reserve(options.repetitions);
+    for (GLuint r{0}; r < options.repetitions; ++r)
+    {
+      const auto start{BenchClock::now()};
+      for (size_t i{0}; i < batch; ++i) body();
+      const std::chrono::duration<double, std::nano> elapsed{BenchClock::now() - start};
+      samples.push_back(elapsed.count() / batch);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result{name, length, grid, batch * options.repetitions};
+    result.median = samples[samples.size() / 2];
+    result.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    for (double sample : samples) result.mean += sample / samples.size();
+    results.push_back(result);
+
+    std::fprintf(stderr, "%-24s length %5u grid %4u  median %12.1f ns  p99 %12.1f ns\n", name.c_str(), length, grid,
+                 result.median, result.p99);
+  }
+
+  /**
+   * Writes every result as JSON.
+   */
+  void writeJSON(std::ostream& out) const
+  {
+    out << "{\n  \"repetitions\": " << options.repetitions << ",\n  \"benchmarks\": [\n";
+    for (size_t i{0}; i < results.size(); ++i)
+    {
+      const BenchResult& r{results[i]};
+      char line[256];
+      std::snprintf(line, sizeof(line),
+                    "    {\"name\": \"%s\", \"length\": %u, \"grid\": %u, \"iterations\": %zu, "
+                    "\"median_ns\": %.2f, \"p99_ns\": %.2f, \"mean_ns\": %.2f}%s\n",
+                    r.name.c_str(), r.length, r.grid, r.iterations, r.median, r.p99, r.mean,
+                    i + 1 < results.size() ? "," : "");
+      out << line;
+    }
+    out << "  ]\n}\n";
+  }
+
+ private:
+  BenchOptions options;
+  std::vector<BenchResult> results;
+};
+
+/**
+ * A snake of the given length laid out in rows across the grid, so it never collides with itself.
+ */
+static std::vector<Cell> makeSegments(const GridInfo& gridInfo, GLuint length)
+{
+  const auto [xSize, ySize]{gridInfo.getGridSizeI()};
+  const int xMax{static_cast<int>(xSize)}, yMax{static_cast<int>(ySize)};
+  std::vector<Cell> segments;
+  for (int i{0}; i < static_cast<int>(length); ++i)
+  {
+    const int row{i / xMax};
+    const int column{i % xMax};
+    segments.push_back({row % 2 ? xMax - 1 - column : column, (row + 1) % yMax});
+  }
+  return segments;
+}
+
+static ScreenSize benchScreen{960, 540};  // GridInfo keeps a reference
+static const GLuint Lengths[]{4, 64, 1024};
+static const GLuint Grids[]{40, 80, 320};
+
+/**
+ * Game logic: moving, collision, eating, wrapping, spawning and starting over.
+ */
+static void benchSimulation(Bench& bench, Shader& shader)
+{
+  for (GLuint grid : Grids)
+  {
+    GridInfo gridInfo(grid, benchScreen);
+    bench.run("grid/getGridSizeI", 0, grid, [&] { keep(gridInfo.getGridSizeI()); });
+
+    Food food(shader, gridInfo);
+    bench.run("food/respawn", 0, grid, [&] { food.respawn(); });
+
+    // Starting a new game: rewinding the arena and building the snake and food again
+    Arena arena(GameWorld::footprint(gridInfo));
+    bench.run("world/reset", 0, grid, [&] { keep(GameWorld::create(arena, shader, gridInfo, grid)); });
+
+    for (GLuint length : Lengths)
+    {
+      Snake snake(shader, gridInfo);
+      snake.setSegments(makeSegments(gridInfo, length));
+      const CellList foodCells{{-1, -1}, {-2, -1}, {-1, -2}, {-2, -2}};
+
+      bench.run("snake/step", length, grid,
+                [&]
+                {
+                  snake.step();
+                  snake.mirrorEdges();
+                });
+      snake.setSegments(makeSegments(gridInfo, length));
+
+      bench.run("snake/isCollided", length, grid, [&] { keep(snake.isCollided()); });
+      bench.run("snake/isEating", length, grid, [&] { keep(snake.isEating(foodCells)); });
+      bench.run("snake/mirrorEdges", length, grid, [&] { snake.mirrorEdges(); });
+      bench.run("snake/getSegmentInstance", length, grid,
+                [&]
+                {
+                  for (size_t i{0}; i < snake.getSegments().size(); ++i) keep(snake.getSegmentInstance(i));
+                });
+    }
+  }
+
+  // What timing every tick and frame costs: a scope around nothing, and reading the percentiles
+  TimingHistogram histogram;
+  bench.run("timing/scope", 0, 0, [&] { TimingScope timing(histogram); });
+  bench.run("timing/summarize", 0, 0, [&] { keep(histogram.summarize()); });
+}
+
+/**
+ * Drawing into a terminal, output built but not written: every call diffs against a frame
+ * where the snake was one move behind, as a tick does.
+ */
+static void benchTerminal(Bench& bench, Shader& shader)
+{
+  for (GLuint grid : Grids)
+  {
+    GridInfo gridInfo(grid, benchScreen);
+    Snake snake(shader, gridInfo);
+    Food food(shader, gridInfo);
+    TerminalRenderer terminal(gridInfo, -1);
+
+    for (GLuint length : Lengths)
+    {
+      snake.setSegments(makeSegments(gridInfo, length));
+      GameSnapshot frames[2];
+      for (GameSnapshot& snapshot : frames)
+      {
+        for (size_t i{0}; i < food.getPosition().size(); ++i) snapshot.items.push_back(food.getCellInstance(i));
+        for (size_t i{0}; i < snake.getSegments().size(); ++i) snapshot.snake.push_back(snake.getSegmentInstance(i));
+        snake.step();
+        snake.mirrorEdges();
+      }
+
+      size_t frame{0};
+      bench.run("terminal/frame", length, grid, [&] { terminal.render(frames[++frame % 2], "status"); });
+    }
+  }
+}
+
+#ifdef SNAKE_HEADLESS
+/**
+ * Drawing a snapshot against an offscreen context: submitting to the render queue alone,
+ * and a whole frame waited on with glFinish.
+ */
+static void benchRender(Bench& bench)
+{
+  std::unique_ptr<HeadlessSurface> surface;
+  try
+  {
+    surface = std::make_unique<HeadlessSurface>(benchScreen);
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << "Skipping render benchmarks: " << error.what() << std::endl;
+    return;
+  }
+
+  Shader shader(ShaderSource::load());
+  CellMesh mesh;
+  mesh.create();
+  RenderQueue queue;
+  GLStateCache state;
+
+  for (GLuint grid : Grids)
+  {
+    GridInfo gridInfo(grid, benchScreen);
+    Snake snake(shader, gridInfo);
+    Food food(shader, gridInfo);
+
+    for (GLuint length : Lengths)
+    {
+      snake.setSegments(makeSegments(gridInfo, length));
+
+      GameSnapshot snapshot;
+      for (size_t i{0}; i < food.getPosition().size(); ++i) snapshot.items.push_back(food.getCellInstance(i));
+      for (size_t i{0}; i < snake.getSegments().size(); ++i) snapshot.snake.push_back(snake.getSegmentInstance(i));
+
+      bench.run("render/submit", length, grid,
+                [&]
+                {
+                  snapshot.draw(queue, mesh, shader);
+                  queue.flush(mesh.getInstanceVBO(), state);
+                });
+      bench.run("render/frame", length, grid,
+                [&]
+                {
+                  glClear(GL_COLOR_BUFFER_BIT);
+                  snapshot.draw(queue, mesh, shader);
+                  queue.flush(mesh.getInstanceVBO(), state);
+                  glFinish();
+                });
+    }
+  }
+
+  mesh.destroy();
+}
+#endif
+
+static const GLuint WarmupTicks{100};    // also frames, for the driver to compile what it needs
+static const GLuint CheckedTicks{20000};  // long enough for big food, deaths and long snakes
+
+/**
+ * Runs bot games tick after tick and counts what the steady state allocates: ticks in every
+ * grid size, drawing their snapshots into a terminal, and with GL when there is an offscreen
+ * context to draw with.
+ * @return Whether nothing was allocated.
+ */
+static bool checkAllocations(Shader& placeholder)
+{
+#ifdef SNAKE_HEADLESS
+  std::unique_ptr<HeadlessSurface> surface;
+  try
+  {
+    surface = std::make_unique<HeadlessSurface>(benchScreen);
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << "Checking ticks only: " << error.what() << std::endl;
+  }
+  const auto shader{surface ? std::make_unique<Shader>(ShaderSource::load()) : std::make_unique<Shader>()};
+  CellMesh mesh;
+  if (surface) mesh.create();
+#endif
+
+  bool clean{true};
+  for (GLuint grid : Grids)
+  {
+    GridInfo gridInfo(grid, benchScreen);
+    Simulation simulation(placeholder, gridInfo);
+    simulation.setAutopilot(true);
+
+#ifdef SNAKE_HEADLESS
+    RenderQueue queue;
+    queue.reserve(2, gridInfo.getCellCount() + 5);
+    GLStateCache state;
+#endif
+
+    TerminalRenderer terminal(gridInfo, -1);
+
+    const AllocCounter& ticks{simulation.getTickAllocations()};
+    uint64_t tickStart{0}, tickBytes{0};
+    AllocCounter warmupFrames, frames, terminalFrames;
+
+    for (GLuint i{0}; i < WarmupTicks + CheckedTicks; ++i)
+    {
+      if (i == WarmupTicks)
+      {
+        tickStart = ticks.allocations;
+        tickBytes = ticks.bytes;
+      }
+      simulation.runTicks(1);
+      simulation.update();
+
+      {
+        AllocScope scope(i < WarmupTicks ? warmupFrames : terminalFrames);
+        terminal.render(simulation.read(), "status");
+      }
+
+#ifdef SNAKE_HEADLESS
+      if (!surface) continue;
+
+      AllocScope scope(i < WarmupTicks ? warmupFrames : frames);
+      simulation.read().draw(queue, mesh, *shader);
+      queue.flush(mesh.getInstanceVBO(), state);
+#endif
+    }
+
+    const uint64_t tickAllocations{ticks.allocations - tickStart};
+    std::fprintf(stderr,
+                 "grid %4u  %u ticks: %llu allocations (%llu bytes)  %llu frames: %llu allocations"
+                 "  terminal frames: %llu allocations\n",
+                 grid, CheckedTicks, static_cast<unsigned long long>(tickAllocations),
+                 static_cast<unsigned long long>(ticks.bytes - tickBytes),
+                 static_cast<unsigned long long>(frames.scopes.load()),
+                 static_cast<unsigned long long>(frames.allocations.load()),
+                 static_cast<unsigned long long>(terminalFrames.allocations.load()));
+    if (tickAllocations || frames.allocations || terminalFrames.allocations) clean = false;
+  }
+
+#ifdef SNAKE_HEADLESS
+  if (surface) mesh.destroy();
+#endif
+  return clean;
+}
+
+static BenchOptions parseOptions(int argc, char* argv[])
+{
+  BenchOptions options;
+  for (int i{1}; i < argc; ++i)
+  {
+    const std::string arg{argv[i]};
+    const bool hasValue{i + 1 < argc};
+
+    if (arg == "--filter" && hasValue)
+    {
+      options.filter = argv[++i];
+    }
+    else if (arg == "--repetitions" && hasValue)
+    {
+      options.repetitions = std::max(1u, static_cast<GLuint>(std::strtoul(argv[++i], nullptr, 10)));
+    }
+    else if (arg == "--warmup-ms" && hasValue)
+    {
+      options.warmupMs = static_cast<GLuint>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (arg == "--json" && hasValue)
+    {
+      options.jsonPath = argv[++i];
+    }
+    else if (arg == "--check-allocations")
+    {
+      options.checkAllocations = true;
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0] << " [--filter TEXT] [--repetitions N] [--warmup-ms N] [--json FILE|-]"
+                   " [--check-allocations]\n";
+      exit(arg == "--help" ? 0 : 1);
+    }
+  }
+  return options;
+}
+
+int main(int argc, char* argv[])
+{
+  const BenchOptions options{parseOptions(argc, argv)};
+  Bench bench(options);
+
+  Shader placeholder;
+  if (options.checkAllocations)
+  {
+    if (!AllocTracker::Enabled)
+    {
+      std::cerr << "Allocations are not counted in this build, configure with -DSNAKE_ALLOC_TRACKING=ON" << std::endl;
+      return 1;
+    }
+    return checkAllocations(placeholder) ? 0 : 1;
+  }
+
+  benchSimulation(bench, placeholder);
+  benchTerminal(bench, placeholder);
+#ifdef SNAKE_HEADLESS
+  benchRender(bench);
+#endif
+
+  if (options.jsonPath == "-")
+  {
+    bench.writeJSON(std::cout);
+  }
+  else if (!options.jsonPath.empty())
+  {
+    std::ofstream file(options.jsonPath);
+    if (!file)
+    {
+      std::cerr << "Failed to open " << options.jsonPath << std::endl;
+      return 1;
+    }
+    bench.writeJSON(file);
+  }
+
+  return 0;
+}
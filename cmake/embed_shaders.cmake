@@ -0,0 +1,23 @@
+# Generates a header holding every GLSL file in SHADER_DIR as a raw string literal.
+# Usage: cmake -DSHADER_DIR=<dir> -DOUTPUT=<header> -P embed_shaders.cmake
+
+file(GLOB SHADER_FILES "${SHADER_DIR}/*.glsl")
+list(SORT SHADER_FILES)
+
+set(CONTENT "#pragma once\n\n// Generated from ${SHADER_DIR} by cmake/embed_shaders.cmake. Do not edit.\n\nnamespace EmbeddedShaders\n{\n")
+
+foreach(SHADER_FILE ${SHADER_FILES})
+  get_filename_component(SHADER_NAME ${SHADER_FILE} NAME_WE)
+  file(READ ${SHADER_FILE} SHADER_CODE)
+  string(APPEND CONTENT "inline constexpr const char ${SHADER_NAME}[]{R\"glsl(${SHADER_CODE})glsl\"};\n")
+endforeach()
+
+string(APPEND CONTENT "}  // namespace EmbeddedShaders\n")
+
+# Only touch the header when the shaders actually changed, so dependants don't rebuild
+if(EXISTS ${OUTPUT})
+  file(READ ${OUTPUT} OLD_CONTENT)
+endif()
+if(NOT "${OLD_CONTENT}" STREQUAL "${CONTENT}")
+  file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Counts heap allocations made through operator new, to keep the tick and frame paths free of them.
+// Compiled in with SNAKE_ALLOC_TRACKING, which replaces the global operator new; without it
+// nothing is counted and every counter stays at 0.
+class AllocTracker
+{
+ public:
+#ifdef SNAKE_ALLOC_TRACKING
+  static constexpr bool Enabled{true};
+#else
+  static constexpr bool Enabled{false};
+#endif
+
+  // Running totals for the calling thread
+  static uint64_t getThreadAllocations();
+  static uint64_t getThreadBytes();
+};
+
+// Allocation totals of one instrumented scope, e.g. every simulation tick.
+// Written by the thread running the scope, readable from any thread.
+struct AllocCounter
+{
+  std::atomic<uint64_t> scopes{0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> last{0};  // allocations in the latest scope
+  std::atomic<uint64_t> peak{0};  // most allocations in one scope
+};
+
+// Adds the allocations the calling thread makes while it is alive to a counter
+class AllocScope
+{
+ public:
+  explicit AllocScope(AllocCounter& counter);
+  ~AllocScope();
+
+  AllocScope(const AllocScope&) = delete;
+  AllocScope& operator=(const AllocScope&) = delete;
+
+ private:
+  AllocCounter& counter;
+  uint64_t startAllocations, startBytes;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Bump allocator over one block allocated up front. Allocating moves a pointer forward,
+// freeing single allocations does nothing, and reset() rewinds to the start in O(1),
+// dropping everything at once. Objects created in it must not need their destructors,
+// beyond releasing memory that also came from the arena.
+class Arena
+{
+ public:
+  explicit Arena(size_t capacity);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+  void reset() { used = 0; }
+
+  template <typename T, typename... Args>
+  T* create(Args&&... args)
+  {
+    return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  size_t getUsed() const { return used; }
+  size_t getCapacity() const { return capacity; }
+
+  // Space an allocation of this size takes, worst case alignment included; for sizing arenas
+  static constexpr size_t footprint(size_t bytes) { return bytes + alignof(std::max_align_t); }
+
+ private:
+  std::unique_ptr<std::byte[]> block;
+  size_t capacity;
+  size_t used{0};
+};
+
+// Standard allocator drawing from an arena, so containers can live in one.
+// Without an arena it falls back to the heap, for objects that are not part of a game.
+template <typename T>
+class ArenaAllocator
+{
+ public:
+  using value_type = T;
+
+  ArenaAllocator(Arena* arena = nullptr) : arena(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.getArena())
+  {
+  }
+
+  T* allocate(size_t count)
+  {
+    if (!arena) return static_cast<T*>(::operator new(count * sizeof(T)));
+    return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* memory, size_t count)
+  {
+    // Arena memory goes back all at once on reset
+    if (!arena) ::operator delete(memory, count * sizeof(T));
+  }
+
+  Arena* getArena() const { return arena; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const
+  {
+    return arena == other.getArena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const
+  {
+    return arena != other.getArena();
+  }
+
+ private:
+  Arena* arena;
+};
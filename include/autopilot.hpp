@@ -0,0 +1,10 @@
+#pragma once
+
+#include <vector>
+
+#include "header.hpp"
+#include "snake.hpp"
+
+// Greedy bot: heads for the closest target cell, never turning into its own body when it can help it.
+// Returns a direction for Snake::setDirection.
+int chooseDirection(const Snake& snake, const CellList& targets, const GridInfo& gridInfo);
@@ -1,24 +1,27 @@
 #pragma once
 
-#include <SFML/System/Clock.hpp>
-
 #include "food.hpp"
 #include "header.hpp"
 
 class BigFood : public Food
 {
  public:
-  BigFood(Shader& shader, const GridInfo& gridInfo);
+  BigFood(Shader& shader, const GridInfo& gridInfo, Arena* arena = nullptr, GameRandom* random = nullptr);
   bool isActive = false;
-  void startCounting(GLfloat snakeMoveDelay);
-  void drawUI() const;
+  void tick();
+  GLfloat getLife() const { return timeToLive / LifeTime; }
+  GLuint getSpawnCount() const { return spawnCount; }
+  static void drawUI(GLfloat life);
   void reset() override;
+  void spawn();
 
   static GLfloat constexpr LifeTime{20.0f};
+  static GLfloat constexpr TickLife{0.3f};  // lifetime a tick takes, about 67 ticks in all
+
+ protected:
+  GLuint getSprite(size_t index) const override;
 
  private:
-  sf::Clock clock;
   float timeToLive{LifeTime};
-  bool isCounting = false;
-  float lastTime = 0.0f;
+  GLuint spawnCount{0};  // spawns since it was created
 };
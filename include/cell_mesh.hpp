@@ -0,0 +1,37 @@
+#pragma once
+
+#include "./glad/glad.h"
+
+// The parts of the cell quad that never change after creation: the unit square's vertices
+// and indices, and the sprite atlas texture. Buffers and textures are shared between contexts
+// of a share group, so one CellQuad can serve every window (see GLResources).
+struct CellQuad
+{
+  GLuint VBO{0}, EBO{0};
+  GLuint atlas{0};
+
+  void create();
+  void destroy();
+};
+
+// The quad every cell is drawn with: a unit square (VAO/VBO/EBO), the per-instance
+// buffer holding each cell's previous and current position and sprite (see CellInstance),
+// and the sprite atlas texture.
+// The VAO and the instance buffer belong to one context; the quad can be borrowed from
+// another context of the same share group instead of being created again.
+class CellMesh
+{
+ public:
+  void create(const CellQuad* shared = nullptr);
+  void destroy();
+
+  const GLuint& getVAO() const { return VAO; }
+  const GLuint& getInstanceVBO() const { return instanceVBO; }
+  const GLuint& getAtlas() const { return quad.atlas; }
+
+ private:
+  CellQuad quad;
+  bool ownsQuad{false};
+  GLuint VAO{0};
+  GLuint instanceVBO{0};  // CellInstance data, refilled by each RenderQueue flush
+};
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3) of a byte range; pass a previous result as crc to continue it
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
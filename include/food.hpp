@@ -2,6 +2,8 @@
 
 #include <SFML/Window.hpp>
 #include <SFML/Window/Event.hpp>
+#include <array>
+#include <vector>
 
 #include "./header.hpp"
 #include "./shader.hpp"
@@ -9,15 +11,16 @@
 class Food
 {
  public:
-  Food(Shader &, const GridInfo &gridInfo, bool isBigFood = false);
+  Food(Shader &, const GridInfo &gridInfo, bool isBigFood = false, Arena *arena = nullptr,
+       GameRandom *random = nullptr);
 
-  void draw(const GLuint &VAO) const;
+  CellInstance getCellInstance(size_t index) const;
   void respawn();
 
   virtual void reset();
 
-  const std::vector<Cell> &getPosition() const { return position; }
-  void setPosition(std::vector<Cell> newPos) { position = newPos; }
+  const CellList &getPosition() const { return position; }
+  void setPosition(const std::vector<Cell> &newPos) { position.assign(newPos.begin(), newPos.end()); }
   const GridInfo &getGridInfo() const { return gridInfo; }
   const unsigned int &getRespawnCounter() const { return respawnCounter; }
   void setRespawnCounter(GLuint counter) { respawnCounter = counter; }
@@ -25,10 +28,13 @@ class Food
  private:
   Shader &shaderProgram;
   const GridInfo &gridInfo;
-  std::vector<Cell> position;  // position of the food, multiple set for big food
+  GameRandom *random;  // nullptr: threadRandom()
+  CellList position;  // position of the food, multiple set for big food
   unsigned int respawnCounter{0};
 
  protected:
-  std::vector<Cell> generatePosition() const;
-  std::vector<Cell> generateBigFoodPosition() const;
+  virtual GLuint getSprite(size_t index) const;
+  Cell generatePosition() const;
+  std::array<Cell, 4> generateBigFoodPosition() const;
+  void placeBigFood();
 };
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glad/glad.h"
+#include "header.hpp"
+
+// Records rendered frames to a video file without stalling the render thread.
+// Frames are read back into a ring of pixel buffer objects: the readback started in
+// frame N is only mapped in frame N + 2, once the GPU is long done with it. A separate
+// encoder thread converts and writes them, as Y4M (.y4m) or as concatenated PPM images
+// (anything else, lossless).
+class FrameRecorder
+{
+ public:
+  FrameRecorder(const ScreenSize& size, const std::string& path, GLuint fps = 60);
+  ~FrameRecorder();
+
+  void capture();
+  void addFrame(const unsigned char* rgba, bool bottomUp);
+  void finish();
+
+  GLuint getFrameCount() const { return frameCount; }
+  size_t getQueuedFrames();  // waiting for the encoder, any thread
+
+  static constexpr GLuint RingSize{3};
+  static constexpr size_t MaxQueuedFrames{16};
+
+ private:
+  struct Frame
+  {
+    std::vector<unsigned char> pixels;
+    bool bottomUp;
+  };
+
+  GLuint width, height;
+  bool y4m;
+  std::ofstream file;
+  GLuint frameCount{0};
+  bool finished{false};
+
+  // Readback ring
+  GLuint PBOs[RingSize]{};
+  GLsync fences[RingSize]{};
+  GLuint nextPBO{0};
+  GLuint inFlight{0};
+  bool hasGL{false};
+  void setupRing();
+  void collect(GLuint index);
+
+  // Encoder thread
+  std::thread encoder;
+  std::mutex mutex;
+  std::condition_variable ready, drained;
+  std::deque<Frame> queue;
+  std::vector<std::vector<unsigned char>> freeBuffers;
+  bool stopping{false};
+  void encoderLoop();
+  std::vector<unsigned char> takeBuffer();
+};
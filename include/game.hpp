@@ -2,45 +2,97 @@
 
 #include <SFML/System/Clock.hpp>
 #include <SFML/Window/Window.hpp>
+#include <atomic>
 
-#include "big_food.hpp"
-#include "food.hpp"
+#include "alloc_tracker.hpp"
+#include "frame_recorder.hpp"
 #include "header.hpp"
+#include "leaderboard.hpp"
+#include "metrics_server.hpp"
+#include "options.hpp"
 #include "render_engine.hpp"
-#include "snake.hpp"
+#include "simulation.hpp"
+#include "software_renderer.hpp"
+#include "surface.hpp"
+#include "telemetry.hpp"
+#include "terminal_renderer.hpp"
 
 class Game
 {
  public:
-  Game();
+  explicit Game(const LaunchOptions& options = {}, Game* shareWith = nullptr);
+  ~Game();
   void run();
+
+  // run() in steps, for driving several games from one loop
+  void start();
+  void frame(sf::Time idleTimeout);
+  void finish();
+  void activate();
+  bool isRunning() const;
+
   void showPauseMenu();
   void showGameOverMenu();
   void resetGame();
   void showHUD();
+  void showTimings();
   const static constexpr GLfloat GameSpeed{0.2f};
 
+  // How long the loop sleeps waiting for input while nothing on screen changes
+  inline static const sf::Time IdleTimeout{sf::milliseconds(500)};
+  // The same with several games in one loop, where one waiting must not stall the others
+  inline static const sf::Time SharedIdleTimeout{sf::milliseconds(1)};
+
+  // How long the terminal loop waits for a key between looks at the simulation
+  static constexpr int TerminalPollMs{2};
+
  private:
-  sf::Window window;
+  LaunchOptions options;
+  std::unique_ptr<Surface> surface;
+  std::shared_ptr<GLResources> resources;   // with the games sharing them, null without GL
+  Shader placeholderShader;                 // the entities' program when there is no GL context
+  std::unique_ptr<FrameRecorder> recorder;  // after surface, so it goes before the GL context
   CellSize cellSize;
   ScreenSize screenSize;
 
   bool showPauseMenuWindow{false};
+  bool showTimingsWindow{false};
   bool showGameOverWindow{false};
   GLfloat snakeSpeed{GameSpeed};  // controls moveDelay
   int difficulty{1};              // 0=Easy, 1=Medium, 2=Hard
-  GLuint highScore{0};
-  GLuint score{0};
+  GLuint highScore{0};      // this session's, see getHighScore()
+  GLuint bestBeforeRun{0};  // high score the last recorded run had to beat
+  GLuint score{0};          // of the latest snapshot
+  GLuint round{0};  // the game the simulation is expected to be in, see GameSnapshot::round
   bool isPlaying{true};
+  bool running{true};
   GLuint gridSize;
+  GLuint frameCount{0};
+  Leaderboard leaderboard;
+  bool runRecorded{false};  // the current round is in the leaderboard
+  TelemetryWriter telemetry;  // only with --telemetry
+  std::atomic<uint64_t> gamesFinished{0};  // recorded runs, for the metrics
+  AllocCounter frameAllocations;  // render thread, one scope per frame
+  TimingHistogram frameTimes;     // rendered frames, from picking up a snapshot to display()
   sf::Clock clock;
 
   GridInfo gridInfo;
 
+  std::unique_ptr<GUI> gui;  // before renderEngine, which shuts it down when destroyed
   std::unique_ptr<RenderEngine> renderEngine;
-  std::unique_ptr<Shader> shaderProgram;
-  std::unique_ptr<Snake> snake;
-  std::unique_ptr<Food> food;
-  std::unique_ptr<BigFood> bigFood;
-  std::unique_ptr<GUI> gui;
+  std::unique_ptr<Simulation> simulation;
+  std::unique_ptr<SoftwareRenderer> softwareRenderer;
+  std::unique_ptr<TerminalRenderer> terminalRenderer;
+  std::string terminalStatus;  // status line, kept to reuse its buffer
+
+  // Last, so its thread stops before anything it reads goes away
+  std::unique_ptr<MetricsServer> metrics;
+
+  GLuint getHighScore() const;
+  void recordRun(DeathCause cause);
+  void writeMetrics(MetricsWriter& out);
+  void setPlaying(bool playing);
+  void quit();
+  void handleTerminalKey(TerminalKey key);
+  std::string_view formatTerminalStatus(const GameSnapshot& snapshot);
 };
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "arena.hpp"
+#include "big_food.hpp"
+#include "food.hpp"
+#include "header.hpp"
+#include "shader.hpp"
+#include "snake.hpp"
+
+// Everything one game owns: the snake and both foods, cells included, laid out in a single arena.
+// A new game rewinds the arena and builds a fresh world at its start rather than resetting and
+// freeing the objects one by one, so a reset costs the same however long the last game ran, and
+// running many short games never fragments the heap.
+// Every random choice in a world comes from its own generator, so a seed and the turns taken
+// replay the same game.
+struct GameWorld
+{
+  uint32_t seed;
+  GameRandom random;  // before the objects, which spawn with it
+  Snake snake;
+  Food food;
+  BigFood bigFood;  // inactive until it spawns
+
+  GameWorld(Shader& shader, const GridInfo& gridInfo, Arena& arena, uint32_t seed);
+
+  static GameWorld& create(Arena& arena, Shader& shader, const GridInfo& gridInfo, uint32_t seed);
+  static size_t footprint(const GridInfo& gridInfo);
+};
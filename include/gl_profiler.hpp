@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+
+// What issued a GL call, set around each part of the frame with GL_CALLER
+enum GLCaller : unsigned
+{
+  CallerOther = 0,  // setup, clears, latency queries
+  CallerCells = 1,  // the instanced cell draws: snake, food and big food
+  CallerImGui = 2,
+  CallerRecorder = 3,  // frame capture read back
+  CallerCount
+};
+
+// GL calls made by one caller in one frame
+struct GLCallCounts
+{
+  uint32_t draws{0};
+  uint32_t uniforms{0};      // glUniform* uploads
+  uint32_t programBinds{0};  // glUseProgram
+  uint32_t vaoBinds{0};      // glBindVertexArray
+  uint32_t uploads{0};       // buffer data, written mappings and texture images
+  uint32_t readbacks{0};     // glReadPixels
+  uint64_t bytes{0};         // moved by uploads and readbacks
+
+  GLCallCounts& operator+=(const GLCallCounts& other);
+};
+
+// Counts the GL calls of every frame, by caller, for the HUD.
+// Compiled in with SNAKE_GL_PROFILE: install() swaps the function pointers glad loaded for
+// wrappers that count, then forward to the driver. Without it nothing is swapped, GL calls cost
+// what they always did, and every count stays at 0.
+// GL is only called from the thread owning the context, so the counts are plain integers.
+class GLProfiler
+{
+ public:
+#ifdef SNAKE_GL_PROFILE
+  static constexpr bool Enabled{true};
+#else
+  static constexpr bool Enabled{false};
+#endif
+
+  static void install();
+  static void endFrame();
+
+  static GLCaller setCaller(GLCaller caller);
+  static const GLCallCounts& getLastFrame(GLCaller caller);
+  static GLCallCounts getLastFrameTotal();
+  static const char* getCallerName(GLCaller caller);
+};
+
+// Attributes the GL calls made while it is alive to a caller
+class GLCallerScope
+{
+ public:
+  explicit GLCallerScope(GLCaller caller) : previous(GLProfiler::setCaller(caller)) {}
+  ~GLCallerScope() { GLProfiler::setCaller(previous); }
+
+  GLCallerScope(const GLCallerScope&) = delete;
+  GLCallerScope& operator=(const GLCallerScope&) = delete;
+
+ private:
+  GLCaller previous;
+};
+
+#ifdef SNAKE_GL_PROFILE
+#define GL_CALLER_CONCAT_(a, b) a##b
+#define GL_CALLER_CONCAT(a, b) GL_CALLER_CONCAT_(a, b)
+#define GL_CALLER(caller) GLCallerScope GL_CALLER_CONCAT(glCallerScope, __LINE__)(caller)
+#else
+#define GL_CALLER(caller) ((void)0)
+#endif
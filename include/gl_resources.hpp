@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+
+#include "cell_mesh.hpp"
+#include "shader.hpp"
+
+// GL objects every game in the process can draw with: the compiled programs, the cell quad and
+// the sprite atlas. They are made once, in the first game's context, and used from every context
+// sharing objects with it (see Surface::create), so a second window neither compiles nor uploads
+// anything again. What GL never shares between contexts (VAOs, framebuffers) and what changes
+// every frame (instance buffers, ImGui's state) stays with each RenderEngine.
+// Nothing is deleted on destruction: the objects go with the share group's last context.
+class GLResources
+{
+ public:
+  GLResources();
+
+  GLResources(const GLResources&) = delete;
+  GLResources& operator=(const GLResources&) = delete;
+
+  Shader& getImGuiShader();
+
+  Shader cellShader;
+  CellQuad quad;
+
+ private:
+  std::unique_ptr<Shader> imguiShader;  // only the ring renderer draws with it
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+
+#include "./glad/glad.h"
+
+// Shadow copy of the GL binding state the renderer changes: program, VAO, buffers, 2D textures
+// and blending. Each setter only calls GL when the value differs from what the cache last set,
+// since drivers, software ones most of all, pay for a bind even when it changes nothing.
+// The cache starts out knowing nothing, so the first call of each kind always goes through.
+// Anything that changes these bindings behind its back must either restore them (the ImGui
+// backend does) or call invalidate().
+class GLStateCache
+{
+ public:
+  GLStateCache() { invalidate(); }
+
+  // Each returns whether it called GL
+  bool useProgram(GLuint program);
+  bool bindVertexArray(GLuint vao);
+  bool bindBuffer(GLenum target, GLuint buffer);
+  bool activeTexture(GLenum unit);
+  bool bindTexture(GLenum target, GLuint texture);
+  bool setBlend(bool enabled);
+  bool blendFunc(GLenum source, GLenum destination);
+
+  void invalidate();
+
+  static constexpr GLuint Unknown{~0u};
+  static constexpr GLuint TextureUnits{8};  // units above this are not cached
+
+ private:
+  GLuint program, vao;
+  GLuint arrayBuffer, pixelPackBuffer, pixelUnpackBuffer;
+  GLuint unit;  // active texture unit, from 0
+  std::array<GLuint, TextureUnits> textures;  // GL_TEXTURE_2D per unit
+  GLuint blend;  // 0 or 1
+  GLenum blendSource, blendDestination;
+
+  GLuint* bufferSlot(GLenum target);
+};
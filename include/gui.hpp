@@ -1,16 +1,30 @@
 #pragma once
 #include <SFML/System/Time.hpp>
-#include <SFML/Window/Window.hpp>
+#include <memory>
 
+#include "gl_resources.hpp"
+#include "gl_state_cache.hpp"
+#include "imgui_ring_renderer.hpp"
+#include "options.hpp"
+#include "surface.hpp"
+
+// ImGui for one surface. Each GUI has its own ImGui context, so games in separate windows
+// keep separate input, layout and draw data; every call makes it current first.
 class GUI
 {
  public:
   GUI();
   ~GUI();
 
-  void init(sf::Window& window);
+  void init(Surface& surface, GLStateCache& state, GLResources& resources, GUIRenderer renderer = GUIRenderer::Ring);
   void shutdown();
 
-  void beginFrame(sf::Window& window, sf::Time deltaTime);
+  void makeCurrent() const;
+  void processEvent(const sf::Event& event) const;
+  void beginFrame(Surface& surface, sf::Time deltaTime);
   void endFrame();
+
+ private:
+  ImGuiContext* context{nullptr};
+  std::unique_ptr<ImGuiRingRenderer> ring;  // null when drawing with the stock backend
 };
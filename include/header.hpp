@@ -1,8 +1,11 @@
 #pragma once
 
 #include <cmath>
+#include <random>
 #include <utility>
+#include <vector>
 
+#include "arena.hpp"
 #include "glad/glad.h"
 
 // Define a simple structure to represent a cell in the grid
@@ -12,6 +15,38 @@ struct Cell
   int y;
 };
 
+// Random numbers for spawning; a game seeds its own so it can be replayed (see GameWorld)
+using GameRandom = std::mt19937;
+
+// The calling thread's generator, randomly seeded, for objects outside a seeded game
+inline GameRandom& threadRandom()
+{
+  static thread_local GameRandom random(std::random_device{}());
+  return random;
+}
+
+// Cells of one game object, stored in its game's arena (see GameWorld) or on the heap
+using CellList = std::vector<Cell, ArenaAllocator<Cell>>;
+
+// Per-instance data for one cell quad: where it was on the previous tick and where it is now
+struct CellInstance
+{
+  GLfloat previousX, previousY;
+  GLfloat x, y;
+  GLuint sprite{0};    // see Sprite in sprite_atlas.hpp
+  GLuint rotation{0};  // clockwise quarter turns
+
+  // Position part way between the two ticks, mirroring vertex.glsl (wraparound included)
+  std::pair<GLfloat, GLfloat> interpolate(GLfloat alpha, const std::pair<GLfloat, GLfloat>& wrapSize) const
+  {
+    GLfloat fromX{previousX}, fromY{previousY};
+    if (std::abs(x - previousX) > 1.5f) fromX += (x > previousX ? 1.0f : -1.0f) * wrapSize.first;
+    if (std::abs(y - previousY) > 1.5f) fromY += (y > previousY ? 1.0f : -1.0f) * wrapSize.second;
+
+    return {fromX + (x - fromX) * alpha, fromY + (y - fromY) * alpha};
+  }
+};
+
 // Define a structure to represent the size of each cell
 struct CellSize
 {
@@ -88,6 +123,20 @@ struct GridInfo
     return std::make_pair(px, py);
   }
 
+  // How far a segment jumps when it wraps around an edge (see Snake::mirrorEdges)
+  std::pair<GLfloat, GLfloat> getWrapSize() const
+  {
+    auto [xMax, yMax] = getGridSizeF();
+    return {xMax + 1.0f, yMax + 1.0f};
+  }
+
+  // Cells the snake can be on, the wraparound row and column included
+  size_t getCellCount() const
+  {
+    auto [xMax, yMax] = getGridSizeI();
+    return static_cast<size_t>(xMax + 1) * static_cast<size_t>(yMax + 1);
+  }
+
   // Helper for window resizing
   void updateScreenSize(const std::pair<int, int>& newSize) { screenSize = newSize; }
   void updategridSize(GLuint newSize) { baseSize = newSize; }
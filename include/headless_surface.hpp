@@ -0,0 +1,38 @@
+#pragma once
+
+#include <EGL/egl.h>
+
+#include "surface.hpp"
+
+// Offscreen surface: a surfaceless (or pbuffer) EGL context rendering into a framebuffer object.
+// Needs no X11/Wayland display, so it runs under e.g. Mesa llvmpipe on CI and render boxes.
+// Several surfaces can share one display and, when asked, their contexts' objects.
+class HeadlessSurface : public Surface
+{
+ public:
+  explicit HeadlessSurface(const ScreenSize& size, const HeadlessSurface* share = nullptr);
+  ~HeadlessSurface() override;
+
+  bool isOpen() const override { return open; }
+  void close() override { open = false; }
+  bool hasContext() const override { return true; }  // until destroyed
+  std::optional<sf::Event> pollEvent() override { return std::nullopt; }
+  ScreenSize getSize() const override { return size; }
+  void display() override;
+  bool setActive() override;
+  GLADloadproc getLoader() const override;
+
+ private:
+  ScreenSize size;
+  bool open{true};
+
+  EGLDisplay eglDisplay{EGL_NO_DISPLAY};
+  EGLConfig eglConfig{nullptr};  // none on the surfaceless platform
+  EGLContext eglContext{EGL_NO_CONTEXT};
+  EGLSurface pbuffer{EGL_NO_SURFACE};
+
+  // Framebuffer objects are never shared, every context has its own
+  GLuint FBO{0}, colorRBO{0}, depthRBO{0};
+  void setupFramebuffer();
+  void initializeDisplay();
+};
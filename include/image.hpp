@@ -0,0 +1,15 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+#include "header.hpp"
+
+// Writes tightly packed RGBA8 pixels as a binary PPM image (alpha is dropped).
+// bottomUp flips the rows, for pixels read back from OpenGL.
+bool writePPM(const std::string& path, GLuint width, GLuint height, const unsigned char* rgba, bool bottomUp = false);
+void writePPM(std::ostream& out, GLuint width, GLuint height, const unsigned char* rgba, bool bottomUp = false);
+
+// YUV4MPEG2 stream: one header, then one 4:4:4 frame per call (BT.601, limited range)
+void writeY4MHeader(std::ostream& out, GLuint width, GLuint height, GLuint fps);
+void writeY4MFrame(std::ostream& out, GLuint width, GLuint height, const unsigned char* rgba, bool bottomUp = false);
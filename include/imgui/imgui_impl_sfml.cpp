@@ -4,6 +4,7 @@
 #include <SFML/Window/Keyboard.hpp>
 #include <SFML/Window/Mouse.hpp>
 #include <SFML/Window/Window.hpp>
+#include <cfloat>
 
 #include "../../include/imgui/imgui.h"
 
@@ -12,11 +13,9 @@ using namespace ImGui;
 static sf::Vector2i g_MousePos;
 static bool g_MouseJustPressed[5] = {false, false, false, false, false};
 
+// The ImGui context is owned by the caller, like the upstream backends
 bool ImGui::SFML::Init(const sf::Window& window)
 {
-  IMGUI_CHECKVERSION();
-  ImGui::CreateContext();
-
   ImGuiIO& io = ImGui::GetIO();
   io.BackendPlatformName = "imgui_impl_sfml";
 
@@ -327,14 +326,20 @@ void ImGui::SFML::Update(const sf::Window& window, sf::Time dt)
   sf::Vector2u size = window.getSize();
   io.DisplaySize = ImVec2((float)size.x, (float)size.y);
 
+  // The mouse is polled globally, so with several windows only the focused one may see it
+  const bool focused = window.hasFocus();
+
   // Mouse position
   sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-  io.AddMousePosEvent((float)mousePos.x, (float)mousePos.y);
+  if (focused)
+    io.AddMousePosEvent((float)mousePos.x, (float)mousePos.y);
+  else
+    io.AddMousePosEvent(-FLT_MAX, -FLT_MAX);
 
   // Mouse buttons
   for (int i = 0; i < 5; ++i)
   {
-    bool down = g_MouseJustPressed[i] || sf::Mouse::isButtonPressed((sf::Mouse::Button)i);
+    bool down = focused && (g_MouseJustPressed[i] || sf::Mouse::isButtonPressed((sf::Mouse::Button)i));
     io.AddMouseButtonEvent(i, down);
     g_MouseJustPressed[i] = false;
   }
@@ -342,4 +347,4 @@ void ImGui::SFML::Update(const sf::Window& window, sf::Time dt)
   ImGui::NewFrame();
 }
 
-void ImGui::SFML::Shutdown() { ImGui::DestroyContext(); }
+void ImGui::SFML::Shutdown() { ImGui::GetIO().BackendPlatformName = nullptr; }
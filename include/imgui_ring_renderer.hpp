@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+
+#include "./glad/glad.h"
+#include "gl_state_cache.hpp"
+#include "imgui/imgui.h"
+#include "shader.hpp"
+
+// Draws ImGui's draw data in place of ImGui_ImplOpenGL3_RenderDrawData, for the HUD that is
+// drawn every frame:
+// - A frame's vertices and indices are copied straight into a persistently mapped buffer
+//   (GL 4.4 buffer storage) instead of re-specifying a buffer per draw list. The buffer is a
+//   ring of RingFrames regions, each fenced after its frame's draws and waited on before it
+//   is written again, so the CPU never writes what the GPU is still reading.
+// - Nothing is saved or restored. Bindings and blending go through the engine's GLStateCache;
+//   for the rest the engine guarantees ImGui's defaults: depth, stencil and face culling off,
+//   filled polygons, additive blend equation, and a viewport covering the framebuffer.
+//   Scissoring is turned back off after drawing.
+// Textures are still created and updated by the stock backend, which must be initialized.
+// The program is shared with the rings of other windows, see GLResources.
+class ImGuiRingRenderer
+{
+ public:
+  ImGuiRingRenderer(GLStateCache& state, Shader& shader);
+  ~ImGuiRingRenderer();
+
+  ImGuiRingRenderer(const ImGuiRingRenderer&) = delete;
+  ImGuiRingRenderer& operator=(const ImGuiRingRenderer&) = delete;
+
+  static bool isSupported();
+  void render(ImDrawData* drawData);
+  void abandon();
+
+  static constexpr GLuint RingFrames{3};
+  static constexpr GLsizeiptr InitialFrameBytes{256 * 1024};  // grows when a frame needs more
+
+ private:
+  GLStateCache& state;
+  Shader& shader;
+  GLint projectionLocation{-1};
+  ImVec4 projected{};  // display rectangle the projection uniform was last set for, by this ring
+
+  GLuint VAO{0}, buffer{0};
+  char* mapped{nullptr};
+  GLsizeiptr frameBytes{0};  // size of one region
+  std::array<GLsync, RingFrames> fences{};
+  GLuint region{0};  // written next
+
+  void createBuffer(GLsizeiptr bytes);
+  void destroyBuffer();
+  void waitRegion(GLuint index);
+  void setupState(ImDrawData* drawData);
+  void updateTextures(ImDrawData* drawData);
+};
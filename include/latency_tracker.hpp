@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+#include "glad/glad.h"
+#include "timing_histogram.hpp"
+
+// Measures input-to-photon latency: from a key event being taken off the window, through
+// the simulation tick that applied it, to the GPU finishing the first frame that shows it.
+// A GL timestamp query goes in right after that frame is presented; its result is mapped
+// back to the CPU clock a few frames later, so nothing ever waits on the GPU. Both stages go
+// into histograms, so tracking a long session takes no memory or time per input.
+class LatencyTracker
+{
+ public:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  void frameShown(TimePoint inputTime, TimePoint appliedTime);
+  void collect();
+  void destroy();
+
+  uint64_t getCount() const { return shown.getCount(); }
+  const TimingHistogram::Summary& getShownSummary() const { return shownSummary; }  // as of the last collect()
+  void report(std::ostream& out) const;
+
+  static constexpr size_t MaxPending{8};  // frames in flight before inputs are no longer tracked
+
+ private:
+  struct Pending
+  {
+    GLuint query;
+    TimePoint inputTime, appliedTime;
+    TimePoint cpuReference;
+    GLint64 gpuReference;
+  };
+
+  std::vector<Pending> pending;
+  std::vector<GLuint> freeQueries;
+  TimingHistogram applied, shown;
+
+  // Kept up to date by collect() for the HUD, which would otherwise summarize every frame
+  TimingHistogram::Summary shownSummary;
+};
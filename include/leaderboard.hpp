@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Every finished run, kept in a local append-only file.
+// The file is a small header followed by fixed-size records, each ending in a CRC-32 of the
+// rest. Records are only ever appended with single write()s, and fsync()ed in batches; after a
+// crash a torn last record fails its checksum or is cut short, and is dropped the next time the
+// file is opened. Opening maps the file and scans it on a background thread, keeping only the
+// best runs in memory, so hundreds of thousands of runs cost nothing at startup and lookups
+// never touch the file.
+class Leaderboard
+{
+ public:
+  enum Source : uint32_t
+  {
+    SourcePlayer,
+    SourceBot,
+  };
+
+  // One run as stored on disk, 32 bytes
+  struct Record
+  {
+    uint64_t time;      // when the run ended, seconds since the Unix epoch
+    uint32_t score;
+    uint32_t length;    // snake segments at the end
+    uint32_t ticks;     // how long the run lasted
+    uint32_t source;    // Source
+    uint32_t reserved;  // 0
+    uint32_t checksum;  // CRC-32 of the fields above
+  };
+
+  Leaderboard() = default;
+  ~Leaderboard();
+
+  Leaderboard(const Leaderboard&) = delete;
+  Leaderboard& operator=(const Leaderboard&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return fd >= 0; }
+
+  // Any thread
+  void add(uint32_t score, uint32_t length, uint32_t ticks, Source source);
+  void sync();
+
+  // Lookups; all 0 / empty until isLoaded()
+  bool isLoaded() const { return loaded.load(std::memory_order_acquire); }
+  uint32_t getBest() const { return best.load(std::memory_order_relaxed); }
+  size_t getRunCount() const;
+  size_t getTopCount() const;
+  Record getTop(size_t rank) const;
+  size_t getDropped() const { return dropped; }  // damaged records skipped when loading
+
+  static std::string defaultPath();
+  static uint32_t checksum(const Record& record);
+
+  static constexpr size_t TopCount{10};
+  static constexpr size_t SyncBatch{64};  // fsync at the latest after this many runs...
+  static constexpr std::chrono::seconds SyncInterval{2};  // ...or once the oldest unsynced one is this old
+
+ private:
+  int fd{-1};
+  std::string path;
+
+  mutable std::mutex mutex;  // guards everything below, held by the loader while it scans
+  std::array<Record, TopCount> top{};  // best first
+  size_t topCount{0};
+  size_t runCount{0};
+  size_t dropped{0};
+  size_t unsynced{0};
+  std::chrono::steady_clock::time_point firstUnsynced;
+  bool closing{false};
+  std::condition_variable wake;  // a first unsynced run, or close()
+
+  std::atomic<uint32_t> best{0};
+  std::atomic<bool> loaded{false};
+  std::thread loader;  // loads the file, then syncs runs that are due until close()
+
+  void run(size_t records);
+  void load(size_t records);
+  void insert(const Record& record);
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "alloc_tracker.hpp"
+#include "timing_histogram.hpp"
+
+// Builds a scrape in the Prometheus text exposition format.
+// Samples of one metric must be written one after the other; its HELP and TYPE lines are only
+// written before the first.
+class MetricsWriter
+{
+ public:
+  // labels is the inside of the braces, e.g. worker="3", or empty
+  void counter(const char* name, const char* help, double value, const std::string& labels = "");
+  void gauge(const char* name, const char* help, double value, const std::string& labels = "");
+  void summary(const char* name, const char* help, const TimingHistogram& histogram, const std::string& labels = "");
+  void allocations(std::initializer_list<std::pair<const char*, const AllocCounter*>> scopes);
+
+  const std::string& getText() const { return text; }
+
+ private:
+  std::string text;
+  const char* lastName{nullptr};
+
+  void header(const char* name, const char* help, const char* type);
+  void sample(const char* name, const char* suffix, const std::string& labels, double value);
+};
+
+// Serves GET /metrics over HTTP on 127.0.0.1 from a thread of its own, for Prometheus to
+// scrape during long headless runs. Each request writes snake_uptime_seconds, then calls the
+// collector on that thread, so it may only read what is safe to read from any thread: atomics,
+// histograms, locked state.
+class MetricsServer
+{
+ public:
+  using Collector = std::function<void(MetricsWriter&)>;
+
+  MetricsServer(uint16_t port, Collector collector);
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  bool isListening() const { return listener >= 0; }
+
+  static constexpr int PollMs{200};  // how long stopping can take
+
+ private:
+  int listener{-1};
+  Collector collector;
+  std::chrono::steady_clock::time_point started{std::chrono::steady_clock::now()};
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+
+  void loop();
+  void serve(int client);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+
+#include "header.hpp"
+
+// Where frames are rendered to
+enum class Backend
+{
+  Window,    // on-screen SFML window
+  Headless,  // offscreen EGL context, no display server needed
+  Software,  // CPU rasterizer into memory, no OpenGL at all
+  Terminal,  // half-block characters with 24-bit color on stdout, for SSH sessions
+};
+
+// How ImGui's draw data reaches GL
+enum class GUIRenderer
+{
+  Stock,  // imgui_impl_opengl3: buffers re-specified per draw list, GL state saved and restored
+  Ring,   // ImGuiRingRenderer: persistently mapped ring buffer, state through the GLStateCache
+};
+
+// Command line options
+struct LaunchOptions
+{
+  Backend backend{Backend::Window};
+  ScreenSize size{0, 0};    // framebuffer size (board cells in a terminal), {0, 0} = fit the screen
+  GLuint frames{0};         // stop after this many frames, 0 = run until closed
+  std::string outputPath;   // save the last frame here (PPM)
+  std::string recordPath;   // record every frame here (Y4M or PPM stream)
+  GLuint spectateGames{0};  // watch this many bot games instead of playing, 0 = play
+  GLuint inputDepth{3};     // turns buffered ahead of the snake
+  std::string tracePath;    // write a Chrome trace of every frame here on exit
+  std::string leaderboardPath;  // record runs here; empty = the default file when playing in a window
+  std::string telemetryPath;    // append a record of every game here, for snake_query
+  GLuint metricsPort{0};        // serve Prometheus metrics on 127.0.0.1, 0 = off
+  GUIRenderer guiRenderer{GUIRenderer::Ring};
+  GLuint instances{1};          // games played at once, each in its own window or offscreen surface
+
+  ScreenSize getScreenSize() const;
+  LaunchOptions forInstance(GLuint index) const;
+  static LaunchOptions parse(int argc, char* argv[]);
+};
@@ -8,12 +8,18 @@
 #include <vector>
 
 #include "./glad/glad.h"
-#include "big_food.hpp"
-#include "food.hpp"
+#include "frame_recorder.hpp"
+#include "cell_mesh.hpp"
+#include "gl_resources.hpp"
+#include "gl_state_cache.hpp"
 #include "gui.hpp"
 #include "header.hpp"
+#include "latency_tracker.hpp"
+#include "render_queue.hpp"
 #include "shader.hpp"
-#include "snake.hpp"
+#include "simulation.hpp"
+#include "surface.hpp"
+#include "timing_histogram.hpp"
 
 class Game;
 
@@ -22,45 +28,70 @@ class RenderEngine
  public:
   using EventCallback = std::function<void(const sf::Event&)>;  // Event listener callback type
 
-  RenderEngine(sf::Window& window, Snake& snake, Shader& shaderProgram, Food& food, ScreenSize& screenSize,
-               GridInfo& gridInfo, GUI& gui, Game* game = nullptr);
+  RenderEngine(Surface& surface, GLResources& resources, ScreenSize& screenSize, GridInfo& gridInfo, GUI& gui,
+               Game* game = nullptr, GUIRenderer guiRenderer = GUIRenderer::Ring);
   ~RenderEngine();
   void clearScreen() const;
   void terminate();
   void render();
+  void waitEvents(sf::Time timeout);
   void addEventListener(const EventCallback& event);
 
-  const GLuint& getVAO() const { return VAO; }
-  sf::Window& getWindow() const { return window; }
+  // Damage tracking: the scene only needs redrawing after something changed
+  void invalidate() { damagedFrames = SettleFrames; }
+  bool isDamaged() const { return damagedFrames > 0; }
+
+  const GLuint& getVAO() const { return mesh.getVAO(); }
+  const RenderStats& getRenderStats() const { return renderQueue.getStats(); }
+  SimClock::time_point getEventTime() const { return eventTime; }
+  const LatencyTracker& getLatency() const { return latency; }
+  const TimingHistogram& getImGuiBuildTimes() const { return imguiBuildTimes; }
+  const TimingHistogram& getDisplayTimes() const { return displayTimes; }
+  Surface& getSurface() const { return surface; }
   const std::pair<GLuint, GLuint>& getScreenSize() const { return screenSize; }
   const GridInfo& getGridInfo() const { return gridInfo; }
   const bool& isImguiInitialized() const { return imguiInitialized; }
 
   void setImguiInitialized(bool status) { imguiInitialized = status; }
-  void setBigFood(BigFood* ptr) { bigFood = ptr; }
+  void setSnapshot(const GameSnapshot* ptr) { snapshot = ptr; }
+  void setRecorder(FrameRecorder* ptr) { recorder = ptr; }
 
  private:
   Game* game{nullptr};
 
-  sf::Window& window;
+  Surface& surface;
 
   bool imguiInitialized = false;
 
-  Snake& snake;
-  Food& food;
-  BigFood* bigFood = nullptr;
-  Shader& shaderProgram;
+  const GameSnapshot* snapshot = nullptr;  // latest simulation state
+  FrameRecorder* recorder = nullptr;
+  Shader& shaderProgram;  // shared with the other windows' engines, see GLResources
   GUI& gui;
   std::pair<GLuint, GLuint>& screenSize;
   GridInfo& gridInfo;
 
   sf::Clock clock;
+  SimClock::time_point eventTime;  // when the event being dispatched was taken off the window
+
+  // ImGui lays out windows a frame after the input that changed them, so draw a few frames per change
+  static constexpr GLuint SettleFrames{3};
+  GLuint damagedFrames{SettleFrames};
+
+  // OpenGL stuffs, this context's own; the quad and atlas in the mesh are shared
+  CellMesh mesh;
+  RenderQueue renderQueue;
+  GLStateCache glState;  // shared with the GUI: the ring renderer binds through it, the stock backend restores
+
+  // Input to photon latency
+  LatencyTracker latency;
 
-  // OpenGL stuffs
-  GLuint VBO, VAO, EBO;
-  void setupQuad();
+  // Where frames spend their time: building the UI, and waiting in display() for the swap
+  TimingHistogram imguiBuildTimes;
+  TimingHistogram displayTimes;
+  SimClock::time_point shownInput;  // the last input a presented frame showed
   void pollEvents();
-  void setupCoordinates() const;
+  void handleEvent(const sf::Event& event);
+  void setupCoordinates();
 
   // Event callbacks
   std::vector<EventCallback> listeners;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "./glad/glad.h"
+#include "gl_state_cache.hpp"
+#include "header.hpp"
+#include "shader.hpp"
+
+// Draw order, lowest first. Everything in a layer is drawn before the next layer starts.
+enum RenderLayer : GLuint
+{
+  LayerBackground = 0,
+  LayerItems = 1,  // food, big food, power-ups
+  LayerSnake = 2,
+};
+
+// GL state a batch of instanced cell quads is drawn with
+struct DrawKey
+{
+  GLuint layer;
+  Shader* shader;
+  GLuint VAO;
+  GLuint texture{0};  // 0 = no texture
+
+  bool operator<(const DrawKey& other) const;
+  bool sameState(const DrawKey& other) const;
+};
+
+// Per frame counters, for the HUD and profiling
+struct RenderStats
+{
+  GLuint packets{0};       // submissions
+  GLuint instances{0};     // quads
+  GLuint draws{0};         // GL draw calls
+  GLuint stateChanges{0};  // program, VAO and texture binds that reached GL
+};
+
+// Collects draw packets from the entities during a frame, then sorts them by state
+// and issues them as the fewest draws: consecutive packets sharing program, VAO and texture
+// are merged into one instanced draw, even across layers since instances are drawn in
+// order, and state is bound through a GLStateCache, so only changes reach GL.
+// All instance data goes up in a single buffer upload per frame.
+class RenderQueue
+{
+ public:
+  CellInstance* submit(const DrawKey& key, size_t count);
+  void flush(GLuint instanceVBO, GLStateCache& state);
+  void reserve(size_t packetCount, size_t instanceCount);
+
+  const RenderStats& getStats() const { return stats; }
+
+ private:
+  struct Packet
+  {
+    DrawKey key;
+    size_t first;  // into staging
+    size_t count;
+  };
+
+  std::vector<Packet> packets;
+  std::vector<CellInstance> staging;  // in submission order
+  std::vector<CellInstance> upload;   // in draw order
+  RenderStats stats;
+};
@@ -1,8 +1,18 @@
 #pragma once
 
 #include "glad/glad.h"
+#include "gl_state_cache.hpp"
 #include <string>
 
+// GLSL sources for one vertex + fragment program
+struct ShaderSource {
+  std::string vertex;
+  std::string fragment;
+
+  // sources embedded at build time, or read from $SNAKE_SHADER_DIR when set
+  static ShaderSource load();
+};
+
 class Shader {
 public:
   // the program ID
@@ -11,11 +21,36 @@ public:
   // constructor reads and builds the shader
   Shader(const char *vertexPath, const char *fragmentPath);
 
+  // builds the shader from source, reusing a cached program binary from cacheDir when possible
+  explicit Shader(const ShaderSource &source, const std::string &cacheDir = "");
+
+  // placeholder program for backends without an OpenGL context, never used to draw
+  Shader() : ID(0) {}
+
   // use/activate the shader
   void use();
+  bool use(GLStateCache &state);
 
   // utility uniform functions
   void setBool(const std::string &name, bool value) const;
   void setInt(const std::string &name, int value) const;
   void setFloat(const std::string &name, float value) const;
+
+  // uniform values are program state, so every context sharing the program sees the same ones
+  bool claimUniforms(const void *owner);
+
+  // shader compilation helpers
+  static bool enableParallelCompile(GLADloadproc load);
+  static std::string defaultCacheDir();
+
+private:
+  GLuint vertexShader{0}, fragmentShader{0};
+  bool pending{false};
+  std::string cachePath;
+  const void *uniformOwner{nullptr};  // who set the uniforms last, see claimUniforms()
+
+  void compile(const ShaderSource &source);
+  void finish();
+  bool loadBinary();
+  void saveBinary() const;
 };
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "alloc_tracker.hpp"
+#include "arena.hpp"
+#include "cell_mesh.hpp"
+#include "game_world.hpp"
+#include "header.hpp"
+#include "render_queue.hpp"
+#include "shader.hpp"
+#include "spsc_queue.hpp"
+#include "timing_histogram.hpp"
+#include "triple_buffer.hpp"
+
+using SimClock = std::chrono::steady_clock;
+
+// Everything the renderer and the HUD need from one simulation tick
+struct GameSnapshot
+{
+  std::vector<CellInstance> items;  // food, then big food
+  std::vector<CellInstance> snake;  // head first
+
+  GLuint round{0};  // games started since launch, counting resets
+  GLuint tick{0};   // ticks since the game started
+  GLuint score{0};
+  bool gameOver{false};
+  uint32_t seed{0};  // the game's, see GameWorld
+  GLuint bigFoodHits{0}, bigFoodMisses{0};
+  bool bigFoodActive{false};
+  GLfloat bigFoodLife{0.0f};  // 1 when it spawns, down to 0
+
+  // Timing of the move between the last two ticks, for interpolation
+  SimClock::time_point lastTick;
+  GLfloat moveDelay{0.2f};
+  bool paused{false};
+  GLfloat pausedProgress{0.0f};
+
+  // The last turn applied: when it was made and when its tick ran, for latency tracking
+  SimClock::time_point inputTime, inputAppliedTime;
+
+  GLfloat getMoveProgress(SimClock::time_point now) const;
+  void draw(RenderQueue& queue, const CellMesh& mesh, Shader& shader) const;
+};
+
+// Requests from the render thread to the simulation
+enum SimCommandType : GLuint
+{
+  CommandTurn,   // value: snake direction
+  CommandPause,
+  CommandResume,
+  CommandSetMoveDelay,  // value: seconds per tick
+  CommandReset,
+};
+
+struct SimCommand
+{
+  SimCommandType type;
+  GLfloat value{0.0f};
+  SimClock::time_point time{};  // when the input happened, for turns
+};
+
+// Runs the game logic on its own thread, on a fixed tick that doesn't care how long frames take.
+// After every tick the state is published as an immutable snapshot through a triple buffer, which
+// the render thread picks up without ever blocking the simulation; input goes the other way
+// through a lock-free single producer / single consumer queue.
+// Turns are buffered rather than applied as they arrive: each tick takes the first turn made
+// before its deadline that is valid against the direction the snake is actually heading, so
+// quick key presses between two ticks play out over the following ticks instead of overwriting
+// each other, and which tick a turn lands on only depends on its timestamp.
+// Once the snake's storage is reserved a tick allocates nothing; the tracker checks that,
+// see getTickAllocations().
+class Simulation
+{
+ public:
+  Simulation(Shader& shader, const GridInfo& gridInfo, GLuint inputDepth = DefaultInputDepth);
+  ~Simulation();
+
+  void start();
+  void stop();
+
+  // Render thread side
+  void send(const SimCommand& command);
+  bool update() { return snapshots.update(); }
+  const GameSnapshot& read() const { return snapshots.read(); }
+
+  // With the thread stopped: a bot steers and starts over when it dies, and ticks can be run
+  // back to back on the calling thread, e.g. to benchmark or check the tick path
+  void setAutopilot(bool enabled) { autopilot = enabled; }
+  void runTicks(GLuint count);
+
+  // Allocations made by every tick so far, counted with SNAKE_ALLOC_TRACKING
+  const AllocCounter& getTickAllocations() const { return tickAllocations; }
+  const TimingHistogram& getTickTimes() const { return tickTimes; }
+  size_t getCommandBacklog() const { return commands.size(); }  // any thread
+
+  static constexpr size_t CommandQueueSize{64};
+  static constexpr GLuint DefaultInputDepth{3};
+
+ private:
+  Shader& shader;
+  const GridInfo& gridInfo;
+  Arena arena;       // the current game's memory, rewound on reset
+  GameWorld* world;  // in the arena
+
+  // Owned by the simulation thread
+  GLuint round{0};
+  GLuint tick{0};
+  GLuint score{0};
+  GLuint bigFoodHits{0};
+  bool playing{true};
+  bool gameOver{false};
+  bool autopilot{false};
+  GLfloat moveDelay{0.2f};
+  GLfloat pausedProgress{0.0f};
+  SimClock::time_point lastTick, nextTick;
+
+  // Turns waiting for a tick, oldest first
+  struct BufferedTurn
+  {
+    int direction;
+    SimClock::time_point time;
+  };
+  std::vector<BufferedTurn> turns;
+  GLuint inputDepth;
+  SimClock::time_point inputTime, inputAppliedTime;
+  void takeTurn();
+
+  void apply(const SimCommand& command);
+  void step();
+  void advance();
+  void publish();
+  void reset();
+  AllocCounter tickAllocations;
+  TimingHistogram tickTimes;
+
+  TripleBuffer<GameSnapshot> snapshots;
+  SpscQueue<SimCommand, CommandQueueSize> commands;
+
+  std::thread thread;
+  std::atomic<bool> stopping{false};
+  std::mutex wakeMutex;  // only to sleep on, the queue itself takes no lock
+  std::condition_variable wake;
+  void loop();
+};
@@ -9,35 +9,33 @@
 #include "./shader.hpp"
 #include "big_food.hpp"
 
-class RenderEngine;
-
 class Snake
 {
  public:
-  Snake(Shader &shader, const GridInfo &gridInfo);
+  Snake(Shader &shader, const GridInfo &gridInfo, Arena *arena = nullptr, GameRandom *random = nullptr);
 
   // components
   const Cell &getHead() const { return segments.front(); }
   void setHead(Cell cell);
-  const std::vector<Cell> getBody() const;
-  const std::vector<Cell> &getSegments() const { return segments; }
-  void setSegments(std::vector<Cell> segs) { segments = segs; }
+  const CellList &getSegments() const { return segments; }
+  void setSegments(const std::vector<Cell> &segs);
+  CellInstance getSegmentInstance(size_t index) const;
 
   //
-  void move();
+  void step();
   void setDirection(int dir);
-  int getDirection() const;
+  bool canTurn(int dir) const { return dir != direction && dir != (direction + 2) % 4; }
+  int getDirection() const { return direction; }
   void setMoveDelay(GLfloat delay) { moveDelay = delay; }
   void grow() { segments.push_back(segments.back()); }
-  GLuint moveAndEat(RenderEngine &renderEngine, Food &food, std::unique_ptr<BigFood> &bigFood);
+  GLuint stepAndEat(Food &food, BigFood &bigFood);
 
   //
-  void attachControl(const sf::Event::KeyPressed &keyPressed);
+  static int getKeyDirection(const sf::Event::KeyPressed &keyPressed);
   void mirrorEdges();
-  void draw(const GLuint &VAO) const;
 
   //
-  bool isEating(const std::vector<Cell> &foodPosition) const;
+  bool isEating(const CellList &foodPosition) const;
   bool isCollided() const;
 
   //
@@ -46,12 +44,13 @@ class Snake
  private:
   Shader &shaderProgram;
   const GridInfo &gridInfo;
-  std::vector<Cell> segments;  // stores the segments of the snake
+  GameRandom *random;  // nullptr: threadRandom()
+  CellList segments;          // stores the segments of the snake
+  CellList previousSegments;  // segments as of the previous move, for render interpolation
   int direction = 1;           // 0: down, 1: right, 2: up, 3: left
-  sf::Clock clock;
   GLfloat moveDelay{0.2f};
-  GLfloat timeSinceLastMove{0.0f};
 
   //
-  std::vector<Cell> generateSegments();
+  void generateSegments(CellList &out) const;
+  GLuint eat(Food &food, BigFood &bigFood);
 };
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "header.hpp"
+#include "simulation.hpp"
+
+// Pure-CPU renderer drawing the same scene as RenderEngine into a memory framebuffer.
+// Needs no OpenGL at all: the framebuffer is split into tiles shared out to worker threads,
+// cleared with SIMD span writes, and every cell quad is filled from the sprite atlas a texel
+// row at a time, each run of one color as a span.
+class SoftwareRenderer
+{
+ public:
+  SoftwareRenderer(const ScreenSize& size, const GridInfo& gridInfo, unsigned threadCount = 0);
+  ~SoftwareRenderer();
+
+  void render(const GameSnapshot& snapshot, GLfloat alpha);
+  bool saveFrame(const std::string& path) const;
+
+  // RGBA8 pixels, top row first
+  const std::vector<uint32_t>& getPixels() const { return pixels; }
+  ScreenSize getSize() const { return {width, height}; }
+
+  static constexpr GLuint TileSize{64};
+
+ private:
+  struct Rect
+  {
+    int x0, y0, x1, y1;          // covered pixels, exclusive max
+    float left, top, size;       // the quad, in pixels (cells are square)
+    GLuint sprite, rotation;
+  };
+
+  const GridInfo& gridInfo;
+  GLuint width, height;
+  GLuint tilesX, tilesY;
+  std::vector<uint32_t> pixels;
+
+  // Per frame scene, binned by tile
+  std::vector<Rect> rects;
+  std::vector<std::vector<uint32_t>> bins;
+  void addCell(const CellInstance& cell, GLfloat alpha);
+  void drawTiles();
+  void drawTile(GLuint tile);
+
+  // Worker threads
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake, done;
+  unsigned generation{0};
+  unsigned busyWorkers{0};
+  bool stopping{false};
+  std::atomic<GLuint> nextTile{0};
+  void workerLoop();
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "arena.hpp"
+#include "cell_mesh.hpp"
+#include "game_world.hpp"
+#include "header.hpp"
+#include "leaderboard.hpp"
+#include "metrics_server.hpp"
+#include "options.hpp"
+#include "render_queue.hpp"
+#include "shader.hpp"
+#include "surface.hpp"
+#include "telemetry.hpp"
+#include "triple_buffer.hpp"
+
+// Spectator mode: many bot games simulated on worker threads, shown as a grid of tiles.
+// Each game publishes a snapshot of its cells through a triple buffer, so the simulation
+// never waits on rendering; the render thread picks up the newest snapshots and draws
+// every tile in a single instanced draw.
+class Spectator
+{
+ public:
+  explicit Spectator(const LaunchOptions& options);
+  ~Spectator();
+
+  void run();
+  void render();
+
+  static constexpr GLuint TileGridSize{24};     // logical grid of each game
+  static constexpr GLfloat TileGap{2.0f};       // cells between tiles
+  static constexpr GLfloat TickInterval{0.05f};  // seconds between simulation steps
+
+ private:
+  struct SimGame
+  {
+    ScreenSize screenSize{1, 1};  // square tiles
+    GridInfo gridInfo{TileGridSize, screenSize};
+    Shader& shader;
+    Arena arena{GameWorld::footprint(gridInfo)};
+    GameWorld* world{&GameWorld::create(arena, shader, gridInfo, threadRandom()())};
+    TripleBuffer<std::vector<CellInstance>> snapshot;
+
+    // Runs end up here when they die, if given
+    Leaderboard* leaderboard;
+    TelemetryWriter* telemetry;
+    GLuint score{0}, ticks{0}, bigFoodHits{0};
+
+    SimGame(Shader& shader, Leaderboard* leaderboard, TelemetryWriter* telemetry)
+        : shader(shader), leaderboard(leaderboard), telemetry(telemetry)
+    {
+    }
+    bool tick();
+  };
+
+  // What one simulation thread has done, for the metrics
+  struct WorkerStats
+  {
+    std::atomic<uint64_t> ticks{0}, games{0};
+    TimingHistogram rounds;  // one tick of each of the thread's games
+    AllocCounter allocations;
+  };
+
+  LaunchOptions options;
+  ScreenSize screenSize;
+  std::unique_ptr<Surface> surface;
+  std::unique_ptr<Shader> shaderProgram;
+  std::unique_ptr<Shader> tileShader;  // same program, drawing the tile backgrounds
+  Shader simShader;  // placeholder, simulations never draw
+  Leaderboard leaderboard;  // only with --leaderboard
+  TelemetryWriter telemetry;  // only with --telemetry
+
+  std::vector<std::unique_ptr<SimGame>> games;
+  GLuint columns, rows;
+  GLfloat tileSpan;  // tile size in cells, gap included
+
+  CellMesh mesh;
+  RenderQueue renderQueue;
+  GLStateCache glState;
+  GLuint frameCount{0};
+  void setupCoordinates();
+
+  // Simulation threads
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<WorkerStats>> workerStats;
+  std::atomic<bool> stopping{false};
+  void simulate(size_t first, size_t stride);
+
+  TimingHistogram frameTimes;
+  std::unique_ptr<MetricsServer> metrics;  // last, so it stops before what it reads goes away
+  void writeMetrics(MetricsWriter& out);
+};
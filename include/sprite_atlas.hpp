@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glad/glad.h"
+
+// Sprites in the atlas. Snake sprites face right (towards the head); a CellInstance picks
+// one along with a number of clockwise quarter turns.
+enum Sprite : GLuint
+{
+  SpriteSolid = 0,  // plain white, tinted by the 'color' uniform
+  SpriteHead,
+  SpriteBody,
+  SpriteCorner,  // joins the left and bottom edges
+  SpriteTail,
+  SpriteFood,
+  SpriteBigFood,  // four sprites: top left, top right, bottom left, bottom right quarters
+};
+
+// One texture holding every sprite, generated at startup so there are no image files to ship.
+// Everything drawn with it fits in a single texture bind and a single instanced draw.
+class SpriteAtlas
+{
+ public:
+  static constexpr GLuint SpriteSize{16};  // texels per sprite side
+  static constexpr GLuint Columns{4};      // sprites per atlas row (and rows per atlas)
+  static constexpr GLuint Size{SpriteSize * Columns};
+
+  // RGBA8 texels, top row first
+  static const std::vector<uint32_t>& getPixels();
+  static GLuint createTexture();
+
+  // CPU lookup matching vertex.glsl: the texels across one row of a quad, left to right
+  static void readRow(GLuint sprite, GLuint rotation, GLuint row, uint32_t* texels);
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free bounded queue for exactly one producer thread and one consumer thread.
+// Each side only writes its own index, so push() and pop() never block; push() fails
+// instead when the consumer has fallen Capacity items behind.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+  static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+ public:
+  // Producer side; returns false when full
+  bool push(const T& value)
+  {
+    const size_t write{tail.load(std::memory_order_relaxed)};
+    if (write - head.load(std::memory_order_acquire) == Capacity) return false;
+
+    items[write & (Capacity - 1)] = value;
+    tail.store(write + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side; returns false when empty
+  bool pop(T& value)
+  {
+    const size_t read{head.load(std::memory_order_relaxed)};
+    if (read == tail.load(std::memory_order_acquire)) return false;
+
+    value = items[read & (Capacity - 1)];
+    head.store(read + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+  // Items waiting; from any thread, then only a recent value
+  size_t size() const
+  {
+    const size_t read{head.load(std::memory_order_acquire)};
+    return tail.load(std::memory_order_acquire) - read;
+  }
+
+ private:
+  T items[Capacity]{};
+
+  // On separate cache lines, so the two threads don't keep stealing each other's
+  alignas(64) std::atomic<size_t> head{0};  // next to pop, written by the consumer
+  alignas(64) std::atomic<size_t> tail{0};  // next to push, written by the producer
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SFML/Window/Event.hpp>
+#include <SFML/Window/Window.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "glad/glad.h"
+#include "header.hpp"
+#include "options.hpp"
+
+// Something with a current OpenGL context that the render engine can draw into
+class Surface
+{
+ public:
+  virtual ~Surface() = default;
+
+  virtual bool isOpen() const = 0;
+  virtual void close() = 0;
+
+  // Whether GL objects can still be deleted; closing a window destroys its context with it
+  virtual bool hasContext() const { return isOpen(); }
+  virtual std::optional<sf::Event> pollEvent() = 0;
+
+  // Blocks until an event arrives or timeout runs out; surfaces without events just poll
+  virtual std::optional<sf::Event> waitEvent(sf::Time /*timeout*/) { return pollEvent(); }
+  virtual ScreenSize getSize() const = 0;
+  virtual void display() = 0;
+
+  // Makes this surface's context the current one, for drawing to it after another surface
+  virtual bool setActive() = 0;
+
+  // GL function loader for this surface's context
+  virtual GLADloadproc getLoader() const = 0;
+
+  // Underlying SFML window, nullptr when there is none
+  virtual sf::Window* getWindow() { return nullptr; }
+
+  bool saveFrame(const std::string& path) const;
+
+  // Window or offscreen surface as the options ask, nullptr for the CPU and terminal backends.
+  // With share, its context shares objects (programs, buffers, textures) with share's
+  static std::unique_ptr<Surface> create(const LaunchOptions& options, const ScreenSize& size,
+                                         const std::string& title, const Surface* share = nullptr);
+
+  // SIGINT and SIGTERM end the render loops like closing the window, so runs shut down cleanly
+  static void catchInterrupts();
+  static bool isInterrupted();
+};
+
+// Regular on-screen SFML window
+class WindowSurface : public Surface
+{
+ public:
+  WindowSurface(const ScreenSize& size, const std::string& title, const sf::ContextSettings& settings);
+
+  bool isOpen() const override { return window.isOpen(); }
+  void close() override { window.close(); }
+  std::optional<sf::Event> pollEvent() override { return window.pollEvent(); }
+  std::optional<sf::Event> waitEvent(sf::Time timeout) override { return window.waitEvent(timeout); }
+  ScreenSize getSize() const override { return {window.getSize().x, window.getSize().y}; }
+  void display() override { window.display(); }
+  bool setActive() override { return window.setActive(true); }
+  GLADloadproc getLoader() const override;
+
+  sf::Window* getWindow() override { return &window; }
+
+ private:
+  sf::Window window;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Per-game telemetry for offline analysis, stored column by column.
+//
+// A telemetry file is a header naming the columns, followed by blocks of up to BlockRows games.
+// Each block starts with its row count, the min and max of every column and a CRC-32, followed
+// by one array per column, 32-byte aligned so a mapped file can be scanned with aligned vector
+// loads. Queries skip whole blocks whose min/max rule them out and only touch the columns
+// they use (see tools/snake_query.cpp).
+
+enum TelemetryAgent : uint8_t
+{
+  AgentPlayer,
+  AgentBot,
+};
+
+enum DeathCause : uint8_t
+{
+  DeathCollision,  // ran into itself
+  DeathReset,      // the player started over
+  DeathQuit,       // the game was closed mid-run
+};
+
+// One finished game
+struct GameRecord
+{
+  uint64_t endTime{0};  // seconds since the Unix epoch
+  uint32_t seed{0};     // see GameWorld
+  uint8_t agent{AgentPlayer};
+  uint16_t gridWidth{0}, gridHeight{0};  // cells, edges included
+  uint8_t difficulty{0};                 // Game::difficulty, 4 = custom speed or a bot
+  float moveDelay{0.0f};                 // seconds per tick
+  uint32_t length{0};
+  uint32_t score{0};
+  uint32_t ticks{0};
+  uint8_t deathCause{DeathCollision};
+  uint32_t bigFoodHits{0}, bigFoodMisses{0};
+};
+
+enum ColumnType : uint32_t
+{
+  ColumnU8,
+  ColumnU16,
+  ColumnU32,
+  ColumnU64,
+  ColumnF32,
+};
+
+struct TelemetryColumn
+{
+  const char* name;
+  ColumnType type;
+};
+
+// Columns in file order; GameRecord fields in the same order
+inline constexpr TelemetryColumn TelemetryColumns[]{
+    {"end_time", ColumnU64},   {"seed", ColumnU32},       {"agent", ColumnU8},           {"grid_width", ColumnU16},
+    {"grid_height", ColumnU16}, {"difficulty", ColumnU8},   {"move_delay", ColumnF32},     {"length", ColumnU32},
+    {"score", ColumnU32},      {"ticks", ColumnU32},      {"death_cause", ColumnU8},     {"big_food_hits", ColumnU32},
+    {"big_food_misses", ColumnU32},
+};
+inline constexpr size_t TelemetryColumnCount{sizeof(TelemetryColumns) / sizeof(TelemetryColumns[0])};
+
+size_t columnTypeSize(ColumnType type);
+
+// Min and max of one column in a block, as doubles whatever the column type
+struct ColumnStats
+{
+  double min, max;
+  uint64_t offset;  // of the column's array, from the start of the block's data
+};
+
+// Appends games to a telemetry file, a block at a time. add() is safe from any thread and
+// only copies the record; a flusher thread transposes, checksums and writes the block with a
+// single write() once it is full, FlushInterval after its first game, or on close().
+// Opening an existing file appends to it, after cutting off a block torn by a crash.
+class TelemetryWriter
+{
+ public:
+  TelemetryWriter() = default;
+  ~TelemetryWriter();
+
+  TelemetryWriter(const TelemetryWriter&) = delete;
+  TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return fd >= 0; }
+
+  void add(const GameRecord& record);
+  void flush();
+  size_t getPending();  // games not written yet
+
+  static constexpr uint32_t BlockRows{65536};
+  static constexpr std::chrono::seconds FlushInterval{30};
+
+ private:
+  int fd{-1};
+  std::string path;
+
+  std::mutex mutex;  // guards pending, firstPending, closing and fd
+  std::vector<GameRecord> pending;
+  std::chrono::steady_clock::time_point firstPending;
+  bool closing{false};
+  std::condition_variable wake;  // a first pending game, a full block, or close()
+  std::thread flusher;
+
+  std::mutex writeMutex;             // held while a block is written, taken before mutex
+  std::vector<unsigned char> block;  // serialization buffer, reused
+
+  bool openFile(const std::string& file);
+  void run();
+  bool writeBlock();
+};
+
+// Read-only view of a telemetry file, mapped into memory
+class TelemetryFile
+{
+ public:
+  struct Block
+  {
+    uint32_t rows;
+    const ColumnStats* stats;    // one per column
+    const unsigned char* data;  // column arrays, see ColumnStats::offset
+  };
+
+  TelemetryFile() = default;
+  ~TelemetryFile();
+
+  TelemetryFile(const TelemetryFile&) = delete;
+  TelemetryFile& operator=(const TelemetryFile&) = delete;
+
+  bool open(const std::string& path, bool verify = false);
+
+  size_t getColumnCount() const { return columns.size(); }
+  const std::string& getColumnName(size_t column) const { return columns[column].name; }
+  ColumnType getColumnType(size_t column) const { return columns[column].type; }
+  int findColumn(const std::string& name) const;
+
+  const std::vector<Block>& getBlocks() const { return blocks; }
+  size_t getRows() const { return rows; }
+  size_t getDamagedBlocks() const { return damaged; }
+
+  // The column's values in a block, 32-byte aligned
+  const void* column(const Block& block, size_t column) const { return block.data + block.stats[column].offset; }
+
+ private:
+  struct Column
+  {
+    std::string name;
+    ColumnType type;
+  };
+
+  void* mapped{nullptr};
+  size_t mappedSize{0};
+  std::vector<Column> columns;
+  std::vector<Block> blocks;
+  size_t rows{0};
+  size_t damaged{0};
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <termios.h>
+#include <vector>
+
+#include "header.hpp"
+#include "simulation.hpp"
+#include "sprite_atlas.hpp"
+
+// Keys the terminal backend reacts to, see TerminalRenderer::readKey()
+enum TerminalKey
+{
+  KeyNone,  // nothing (more) to read
+  KeyUp,
+  KeyDown,
+  KeyLeft,
+  KeyRight,
+  KeyPause,  // space, p or Esc
+  KeyReset,  // r
+  KeyQuit,   // q
+};
+
+// Draws the board into a terminal with 24-bit color, for SSH sessions and servers without a
+// display. Each character shows two cells stacked: '▀' in the top cell's color over the bottom
+// cell's background. The renderer remembers what the terminal shows and only writes the
+// characters that changed, skipping the cursor over the rest and setting colors only when they
+// differ from the last ones written, so a tick costs tens of bytes rather than a screenful.
+// The last terminal row is a status line. Cells are drawn where they are, not interpolated.
+class TerminalRenderer
+{
+ public:
+  explicit TerminalRenderer(const GridInfo& gridInfo, int fd = 1);
+  ~TerminalRenderer();
+
+  TerminalRenderer(const TerminalRenderer&) = delete;
+  TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+  void render(const GameSnapshot& snapshot, std::string_view status);
+  void invalidate();
+
+  TerminalKey readKey();
+  void waitInput(int timeoutMs) const;
+
+  // What the last render() wrote
+  const std::string& getOutput() const { return output; }
+
+  static ScreenSize getBoardSize(int fd = 1);
+
+  static constexpr GLuint MinColumns{20}, MinRows{8};  // board cells
+  static constexpr uint32_t Unknown{~0u};
+
+ private:
+  const GridInfo& gridInfo;
+  int fd;  // written to, -1 = only build the output
+  bool rawInput{false};
+  termios savedMode{};
+
+  GLuint columns, rows;  // characters of the board, each two cells high
+  std::vector<uint32_t> cells;  // 0xRRGGBB per cell, the frame being drawn
+  std::vector<uint64_t> shown;  // per character, top << 32 | bottom as on screen, ~0 = unknown
+  std::string shownStatus;
+  bool statusShown{false};
+  bool clearScreen{true};
+
+  // The terminal's cursor and colors, as left by the bytes written so far
+  GLuint cursorRow{Unknown}, cursorColumn{Unknown};
+  uint32_t foreground{Unknown}, background{Unknown};
+
+  std::array<uint32_t, SpriteAtlas::Columns * SpriteAtlas::Columns> spriteColors{};  // mean of opaque texels
+  std::string output;
+
+  void paint(const CellInstance& cell);
+  void drawCharacter(GLuint row, GLuint column, uint32_t top, uint32_t bottom);
+  void drawStatus(std::string_view status);
+  void moveTo(GLuint row, GLuint column);
+  void setColors(uint32_t foreground, uint32_t background);
+  void appendColor(uint32_t color);
+  void appendNumber(uint32_t value);
+  void write(std::string_view bytes) const;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <utility>
+
+// Distribution of a duration that is measured over and over, e.g. every tick or every frame.
+// Durations go into log-bucketed counters, HDR histogram style: each power of two is split into
+// SubBuckets linear buckets, so any percentile is within 1/SubBuckets of the true value from
+// nanoseconds to a minute, in a fixed array. Recording is a few relaxed atomic increments: it
+// never locks or allocates, and any thread can read percentiles while another records.
+class TimingHistogram
+{
+ public:
+  // Percentiles in milliseconds
+  struct Summary
+  {
+    uint64_t count{0};
+    double mean{0}, p50{0}, p99{0}, p999{0}, max{0};
+  };
+
+  void record(std::chrono::nanoseconds duration);
+  Summary summarize() const;
+  uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+
+  static void report(std::ostream& out, const char* title,
+                     std::initializer_list<std::pair<const char*, const TimingHistogram*>> histograms);
+
+  static constexpr unsigned SubBucketBits{5};
+  static constexpr uint64_t SubBuckets{1u << SubBucketBits};
+  static constexpr unsigned MaxBits{36};  // ~69 s, longer durations land in the last bucket
+  static constexpr size_t BucketCount{(MaxBits - SubBucketBits + 1) * SubBuckets};
+
+ private:
+  std::array<std::atomic<uint64_t>, BucketCount> buckets{};
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> total{0};    // nanoseconds
+  std::atomic<uint64_t> largest{0};  // nanoseconds
+
+  static size_t bucketOf(uint64_t nanoseconds);
+  static uint64_t bucketTop(size_t bucket);
+};
+
+// Records how long it is alive into a histogram
+class TimingScope
+{
+ public:
+  explicit TimingScope(TimingHistogram& histogram)
+      : histogram(histogram), start(std::chrono::steady_clock::now())
+  {
+  }
+  ~TimingScope() { histogram.record(std::chrono::steady_clock::now() - start); }
+
+  TimingScope(const TimingScope&) = delete;
+  TimingScope& operator=(const TimingScope&) = delete;
+
+ private:
+  TimingHistogram& histogram;
+  std::chrono::steady_clock::time_point start;
+};
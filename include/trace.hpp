@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Timeline tracing: scoped timers around the phases of a frame or tick, written out as
+// Chrome trace JSON to open in Perfetto (ui.perfetto.dev) or chrome://tracing.
+// Compiled in with SNAKE_TRACE, and recording only after Trace::start(). Each thread appends
+// to its own buffer, so a scope costs two clock reads and a store, with no locking.
+class Trace
+{
+ public:
+  static void start();
+  static bool write(const std::string& path);
+  static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+  static void nameThread(const char* name);
+  static uint64_t now();
+  static void record(const char* name, uint64_t start, uint64_t end);
+
+ private:
+  static std::atomic<bool> enabled;
+};
+
+// Times the enclosing scope
+class TraceScope
+{
+ public:
+  explicit TraceScope(const char* name) : name(Trace::isEnabled() ? name : nullptr)
+  {
+    if (this->name) start = Trace::now();
+  }
+  ~TraceScope()
+  {
+    if (name) Trace::record(name, start, Trace::now());
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* name;  // a string literal, or null when not tracing
+  uint64_t start{0};
+};
+
+#ifdef SNAKE_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
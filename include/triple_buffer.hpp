@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer / single consumer hand-off of the latest value.
+// The writer fills writeBuffer() and publish()es it; the reader calls update() and then
+// read()s the newest published value. Neither side ever waits for the other: there is
+// always a third buffer to swap with, and values the reader never got to are skipped.
+template <typename T>
+class TripleBuffer
+{
+ public:
+  // Writer side
+  T& writeBuffer() { return buffers[back]; }
+  void publish() { back = middle.exchange(back | FreshBit, std::memory_order_acq_rel) & IndexMask; }
+
+  // Before either side starts: calls f on all three buffers, e.g. to reserve their storage
+  template <typename F>
+  void prepare(F&& f)
+  {
+    for (T& buffer : buffers) f(buffer);
+  }
+
+  // Reader side; returns whether a newer value came in
+  bool update()
+  {
+    if (!(middle.load(std::memory_order_relaxed) & FreshBit)) return false;
+
+    front = middle.exchange(front, std::memory_order_acq_rel) & IndexMask;
+    return true;
+  }
+  const T& read() const { return buffers[front]; }
+
+ private:
+  static constexpr unsigned IndexMask{3};
+  static constexpr unsigned FreshBit{4};  // the middle buffer holds a value the reader hasn't seen
+
+  T buffers[3]{};
+  std::atomic<unsigned> middle{1};
+  unsigned back{0};   // owned by the writer
+  unsigned front{2};  // owned by the reader
+};
@@ -0,0 +1,82 @@
+#include "../include/alloc_tracker.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+// Plain integers: constant initialized, so they are usable from the first allocation on
+thread_local uint64_t threadAllocations{0};
+thread_local uint64_t threadBytes{0};
+}  // namespace
+
+uint64_t AllocTracker::getThreadAllocations() { return threadAllocations; }
+
+uint64_t AllocTracker::getThreadBytes() { return threadBytes; }
+
+AllocScope::AllocScope(AllocCounter& counter)
+    : counter(counter), startAllocations(threadAllocations), startBytes(threadBytes)
+{
+}
+
+AllocScope::~AllocScope()
+{
+  const uint64_t allocations{threadAllocations - startAllocations};
+
+  counter.scopes.fetch_add(1, std::memory_order_relaxed);
+  counter.allocations.fetch_add(allocations, std::memory_order_relaxed);
+  counter.bytes.fetch_add(threadBytes - startBytes, std::memory_order_relaxed);
+  counter.last.store(allocations, std::memory_order_relaxed);
+  if (allocations > counter.peak.load(std::memory_order_relaxed))
+  {
+    counter.peak.store(allocations, std::memory_order_relaxed);
+  }
+}
+
+#ifdef SNAKE_ALLOC_TRACKING
+// Replacements for the global allocation functions: count, then hand over to malloc
+
+static void* countedAlloc(std::size_t size, std::size_t alignment)
+{
+  ++threadAllocations;
+  threadBytes += size;
+
+  if (size == 0) size = 1;
+  if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+
+  // aligned_alloc wants the size to be a multiple of the alignment
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void* countedAllocOrThrow(std::size_t size, std::size_t alignment)
+{
+  void* memory{countedAlloc(size, alignment)};
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new(std::size_t size) { return countedAllocOrThrow(size, 0); }
+void* operator new[](std::size_t size) { return countedAllocOrThrow(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return countedAllocOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return countedAllocOrThrow(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, 0); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+#endif
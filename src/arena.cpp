@@ -0,0 +1,21 @@
+#include "../include/arena.hpp"
+
+#include <cstdint>
+
+Arena::Arena(size_t capacity) : block(std::make_unique<std::byte[]>(capacity)), capacity(capacity) {}
+
+/**
+ * Takes memory from the arena.
+ * @param bytes Size of the allocation.
+ * @param alignment Its alignment, a power of two.
+ * @return The memory; throws std::bad_alloc when the arena is full.
+ */
+void* Arena::allocate(size_t bytes, size_t alignment)
+{
+  const auto base{reinterpret_cast<std::uintptr_t>(block.get())};
+  const size_t start{((base + used + alignment - 1) & ~(alignment - 1)) - base};
+  if (start + bytes > capacity) throw std::bad_alloc();
+
+  used = start + bytes;
+  return block.get() + start;
+}
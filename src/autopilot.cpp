@@ -0,0 +1,62 @@
+#include "../include/autopilot.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+/**
+ * Picks the direction for the snake's next step.
+ * Distances wrap around the edges like the snake does (see Snake::mirrorEdges).
+ * @param snake The snake to steer.
+ * @param targets The cells to head for, usually the food.
+ * @param gridInfo Grid the snake moves on.
+ * @return The direction (0: down, 1: right, 2: up, 3: left).
+ */
+int chooseDirection(const Snake& snake, const CellList& targets, const GridInfo& gridInfo)
+{
+  static const Cell steps[4]{{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+
+  auto [xMax, yMax]{gridInfo.getGridSizeI()};
+  const int width{static_cast<int>(xMax) + 1};
+  const int height{static_cast<int>(yMax) + 1};
+
+  // Shortest way across the wrapping grid
+  auto distance{[&](int from, int to, int size)
+                {
+                  const int d{std::abs(to - from) % size};
+                  return std::min(d, size - d);
+                }};
+
+  const auto& segments{snake.getSegments()};
+  const Cell& head{snake.getHead()};
+  const int reverse{(snake.getDirection() + 2) % 4};
+
+  int best{snake.getDirection()};
+  int bestDistance{INT_MAX};
+
+  for (int dir{0}; dir < 4; ++dir)
+  {
+    if (dir == reverse) continue;
+
+    const Cell next{(head.x + steps[dir].x + width) % width, (head.y + steps[dir].y + height) % height};
+
+    // The tail moves out of the way on this step
+    const bool blocked{std::any_of(segments.begin(), segments.end() - 1,
+                                   [&](const Cell& cell) { return cell.x == next.x && cell.y == next.y; })};
+    if (blocked) continue;
+
+    int nearest{INT_MAX - 1};
+    for (const auto& target : targets)
+    {
+      nearest = std::min(nearest, distance(next.x, target.x, width) + distance(next.y, target.y, height));
+    }
+
+    if (nearest < bestDistance)
+    {
+      best = dir;
+      bestDistance = nearest;
+    }
+  }
+
+  return best;
+}
@@ -1,50 +1,34 @@
 #include "../include/big_food.hpp"
 
 #include "../include/imgui/imgui.h"
+#include "../include/sprite_atlas.hpp"
 
-BigFood::BigFood(Shader& shader, const GridInfo& gridInfo) : Food(shader, gridInfo, true) {}
+BigFood::BigFood(Shader& shader, const GridInfo& gridInfo, Arena* arena, GameRandom* random)
+    : Food(shader, gridInfo, true, arena, random)
+{
+}
 
 /**
- * Starts or updates the countdown timer for big food expiration.
- * The countdown scales dynamically with the snake's move delay (speed).
- *
- * @param snakeMoveDelay The delay between snake moves (smaller = faster).
+ * Counts one simulation tick off the big food's lifetime, expiring it when none is left.
+ * Ticks rather than wall-clock time, so a seed and the turns taken replay the same expiry
+ * however the ticks were scheduled; at the baseline speed a tick takes TickLife.
  */
-void BigFood::startCounting(GLfloat snakeMoveDelay)
+void BigFood::tick()
 {
-  if (!isCounting)
-  {
-    // Start countdown on first call
-    clock.restart();
-    isCounting = true;
-    lastTime = 0.0f;
-    return;
-  }
-
-  // Time delta
-  float currentTime{clock.getElapsedTime().asSeconds()};
-  float deltaTime{currentTime - lastTime};
-  lastTime = currentTime;
-
-  // Adjust expiration rate based on snake speed
-  const float baselineDelay{0.3f};  // typical snake speed baseline
-  float speedFactor{baselineDelay / snakeMoveDelay};
-
-  // Apply scaled time decay
-  timeToLive -= deltaTime * speedFactor;
+  timeToLive -= TickLife;
 
   if (timeToLive <= 0.0f)
   {
     isActive = false;
-    isCounting = false;
     timeToLive = LifeTime;  // reset for next spawn
   }
 }
 
 /**
  * Draw UI to show progress timer for big food decay.
+ * @param life What is left of the big food's lifetime, from getLife().
  */
-void BigFood::drawUI() const
+void BigFood::drawUI(GLfloat life)
 {
   ImVec2 windowPos{ImVec2((ImGui::GetIO().DisplaySize.x / 2) - 1.0f, ImGui::GetIO().DisplaySize.y - 40.0f)};
   ImVec2 pivot{ImVec2(0.5f, 0.5f)};  // center
@@ -52,9 +36,7 @@ void BigFood::drawUI() const
   ImGui::SetNextWindowPos(windowPos, ImGuiCond_Always, pivot);
   ImGui::Begin("big food time board", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize);
 
-  GLfloat progress{(timeToLive - 0.0f) / (LifeTime - 0.0f)};
-
-  ImGui::ProgressBar(progress, ImVec2(0.0f, 0.0f), "");
+  ImGui::ProgressBar(life, ImVec2(0.0f, 0.0f), "");
   ImGui::End();
 }
 
@@ -63,11 +45,24 @@ void BigFood::drawUI() const
  */
 void BigFood::reset()
 {
-  setPosition(Food::generateBigFoodPosition());
+  placeBigFood();
   setRespawnCounter(0);
 
   timeToLive = LifeTime;
-  isCounting = false;
-  lastTime = 0.0f;
   isActive = false;
 }
+
+/**
+ * Puts the big food on the grid again at a new position, with its full lifetime.
+ */
+void BigFood::spawn()
+{
+  reset();
+  isActive = true;
+  ++spawnCount;
+}
+
+/**
+ * Big food is one sprite split over its 2x2 cells, in generateBigFoodPosition order.
+ */
+GLuint BigFood::getSprite(size_t index) const { return SpriteBigFood + static_cast<GLuint>(index); }
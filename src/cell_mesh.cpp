@@ -0,0 +1,105 @@
+#include "../include/cell_mesh.hpp"
+
+#include <cstddef>
+#include <vector>
+
+#include "../include/header.hpp"
+#include "../include/sprite_atlas.hpp"
+
+/**
+ * Uploads the unit square and generates the sprite atlas, in the current context.
+ * The quad is defined with 4 vertices and 2 triangles, and drawn once per cell instance.
+ */
+void CellQuad::create()
+{
+  // Define a simple 1x1 square centered on the origin
+  std::vector<GLfloat> vertices{
+      0.5f,  0.5f,  0.0f,  // top right
+      0.5f,  -0.5f, 0.0f,  // bottom right
+      -0.5f, -0.5f, 0.0f,  // bottom left
+      -0.5f, 0.5f,  0.0f   // top left
+  };
+
+  std::vector<GLuint> indices{
+      0, 1, 3,  // first triangle
+      1, 2, 3   // second triangle
+  };
+
+  glGenBuffers(1, &VBO);
+  glGenBuffers(1, &EBO);
+
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+
+  // Not GL_ELEMENT_ARRAY_BUFFER, which would need a VAO bound to hold it
+  glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+  glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  atlas = SpriteAtlas::createTexture();
+}
+
+/**
+ * Deletes the buffers and the atlas; a context of the share group must be current.
+ */
+void CellQuad::destroy()
+{
+  glDeleteBuffers(1, &VBO);
+  glDeleteBuffers(1, &EBO);
+  glDeleteTextures(1, &atlas);
+}
+
+/**
+ * Sets up the VAO and instance buffer of the current context around a quad.
+ * @param shared Quad created in a context sharing objects with this one, or nullptr to create
+ * one owned by this mesh.
+ */
+void CellMesh::create(const CellQuad* shared)
+{
+  ownsQuad = !shared;
+  if (shared)
+  {
+    quad = *shared;
+  }
+  else
+  {
+    quad.create();
+  }
+
+  glGenVertexArrays(1, &VAO);
+  glGenBuffers(1, &instanceVBO);
+
+  glBindVertexArray(VAO);
+
+  glBindBuffer(GL_ARRAY_BUFFER, quad.VBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad.EBO);
+
+  // Vertex attribute (position only)
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+  glEnableVertexAttribArray(0);
+
+  // Instance attributes: previous and current cell, sprite, advancing once per quad
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CellInstance), (GLvoid*)offsetof(CellInstance, previousX));
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(CellInstance), (GLvoid*)offsetof(CellInstance, x));
+  glEnableVertexAttribArray(1);
+  glEnableVertexAttribArray(2);
+  glVertexAttribIPointer(3, 2, GL_UNSIGNED_INT, sizeof(CellInstance), (GLvoid*)offsetof(CellInstance, sprite));
+  glEnableVertexAttribArray(3);
+  glVertexAttribDivisor(1, 1);
+  glVertexAttribDivisor(2, 1);
+  glVertexAttribDivisor(3, 1);
+
+  // Safety: unbind
+  glBindVertexArray(0);
+}
+
+/**
+ * Deletes the GL objects, and the quad when it is this mesh's own; the context must still be current.
+ */
+void CellMesh::destroy()
+{
+  glDeleteVertexArrays(1, &VAO);
+  glDeleteBuffers(1, &instanceVBO);
+  if (ownsQuad) quad.destroy();
+}
@@ -0,0 +1,36 @@
+#include "../include/checksum.hpp"
+
+namespace
+{
+// One table lookup per byte
+struct CrcTable
+{
+  uint32_t entries[256];
+
+  constexpr CrcTable() : entries()
+  {
+    for (uint32_t i{0}; i < 256; ++i)
+    {
+      uint32_t crc{i};
+      for (int bit{0}; bit < 8; ++bit) crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320u : 0u);
+      entries[i] = crc;
+    }
+  }
+};
+
+constexpr CrcTable crcTable;
+}  // namespace
+
+/**
+ * CRC-32 of a byte range.
+ * @param data First byte.
+ * @param size Number of bytes.
+ * @param crc CRC of the bytes before these, to checksum data in pieces; 0 to start.
+ */
+uint32_t crc32(const void* data, size_t size, uint32_t crc)
+{
+  const auto* bytes{static_cast<const unsigned char*>(data)};
+  crc = ~crc;
+  for (size_t i{0}; i < size; ++i) crc = (crc >> 8) ^ crcTable.entries[(crc ^ bytes[i]) & 0xFF];
+  return ~crc;
+}
@@ -4,13 +4,21 @@
 #include <random>
 
 #include "../include/glad/glad.h"
-#include "../include/glm/gtc/type_ptr.hpp"
+#include "../include/sprite_atlas.hpp"
 
-Food::Food(Shader& shaderProgram, const GridInfo& gridInfo, bool isBigFood)
-    : shaderProgram(shaderProgram),
-      gridInfo(gridInfo),
-      position(isBigFood ? generateBigFoodPosition() : generatePosition())
+Food::Food(Shader& shaderProgram, const GridInfo& gridInfo, bool isBigFood, Arena* arena, GameRandom* random)
+    : shaderProgram(shaderProgram), gridInfo(gridInfo), random(random), position(arena)
 {
+  // Big food has four cells; reserving them now keeps respawns from allocating
+  position.reserve(4);
+  if (isBigFood)
+  {
+    placeBigFood();
+  }
+  else
+  {
+    position.assign(1, generatePosition());
+  }
 }
 
 /**
@@ -18,19 +26,19 @@ Food::Food(Shader& shaderProgram, const GridInfo& gridInfo, bool isBigFood)
  */
 void Food::reset()
 {
-  setPosition(generatePosition());
+  position.assign(1, generatePosition());
   setRespawnCounter(0);
 }
 
 /**
  * Generates a random position for the food within the grid.
- * @return A vector of Cells representing the position of the food.
+ * @return The cell of the food.
  */
-std::vector<Cell> Food::generatePosition() const
+Cell Food::generatePosition() const
 {
   auto [xMax, yMax]{gridInfo.getGridSizeI()};
 
-  static std::mt19937 gen(std::random_device{}());
+  GameRandom& gen{random ? *random : threadRandom()};
   std::uniform_int_distribution<int> distX(2, xMax - 2);
   std::uniform_int_distribution<int> distY(2, yMax - 2);
 
@@ -38,25 +46,34 @@ std::vector<Cell> Food::generatePosition() const
   // std::cout << "Food spawned at: (" << cell.x << ", " << cell.y << ")\n";
   // std::cout << "[DEBUG] gridWidth=" << xMax << " gridHeight=" << yMax << "\n";
 
-  return {cell};
+  return cell;
 }
 
 /**
  * Generates random positions for big food within the grid.
  * Big food occupies a 2x2 area, so the positions are generated accordingly.
- * @return A vector of Cells representing the positions of the big food.
+ * @return The four cells of the big food.
  */
-std::vector<Cell> Food::generateBigFoodPosition() const
+std::array<Cell, 4> Food::generateBigFoodPosition() const
 {
   auto [xMax, yMax]{gridInfo.getGridSizeI()};
 
-  static std::mt19937 gen(std::random_device{}());
+  GameRandom& gen{random ? *random : threadRandom()};
   std::uniform_int_distribution<int> distX(4, xMax - 4);
   std::uniform_int_distribution<int> distY(4, yMax - 4);
   int rN{distX(gen)};
   int rN1{distY(gen)};
 
-  return {{rN, rN1}, {rN + 1, rN1}, {rN, rN1 + 1}, {rN + 1, rN1 + 1}};
+  return {{{rN, rN1}, {rN + 1, rN1}, {rN, rN1 + 1}, {rN + 1, rN1 + 1}}};
+}
+
+/**
+ * Moves the food to a new random 2x2 area, reusing the position's storage.
+ */
+void Food::placeBigFood()
+{
+  const std::array<Cell, 4> cells{generateBigFoodPosition()};
+  position.assign(cells.begin(), cells.end());
 }
 
 /**
@@ -65,34 +82,21 @@ std::vector<Cell> Food::generateBigFoodPosition() const
 void Food::respawn()
 {
   respawnCounter++;
-  position = generatePosition();
+  position.assign(1, generatePosition());
 }
 
 /**
- * Draws the food on the screen using OpenGL.
- * The food is drawn as a scaled and translated quad.
- * @param VAO The Vertex Array Object for the quad.
+ * Instance data for one food cell. Food never moves, so its previous cell is its current one.
+ * @param index The cell index.
  */
-void Food::draw(const GLuint& VAO) const
+CellInstance Food::getCellInstance(size_t index) const
 {
-  shaderProgram.use();
-  glBindVertexArray(VAO);
-
-  GLint modelLoc{glGetUniformLocation(shaderProgram.ID, "model")};
-  if (modelLoc == -1) std::cerr << "Warning: 'model' uniform not found in shader\n";
-
-  for (const auto& pos : position)
-  {
-    glm::mat4 model{1.0f};
-
-    // Place food directly at its grid coordinate
-    model = glm::translate(model, glm::vec3(pos.x - 0.5f, pos.y - 0.5f, 0.0f));
-
-    // Scale each cell to a scale factor
-    model = glm::scale(model, scaleFactor * glm::vec3(1.0f));
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-  }
-  glBindVertexArray(0);
+  const GLfloat x{static_cast<GLfloat>(position[index].x)}, y{static_cast<GLfloat>(position[index].y)};
+  return {x, y, x, y, getSprite(index)};
 }
+
+/**
+ * The sprite for one food cell.
+ * @param index The cell index.
+ */
+GLuint Food::getSprite(size_t /*index*/) const { return SpriteFood; }
@@ -0,0 +1,195 @@
+#include "../include/frame_recorder.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "../include/image.hpp"
+
+/**
+ * Opens the output file and starts the encoder thread.
+ * @param size Frame dimensions (width, height); frames are read from the bottom-left corner.
+ * @param path The file to write; a .y4m extension selects Y4M, anything else PPM frames.
+ * @param fps Frame rate written into the Y4M header.
+ */
+FrameRecorder::FrameRecorder(const ScreenSize& size, const std::string& path, GLuint fps)
+    : width(size.first),
+      height(size.second),
+      y4m(path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0),
+      file(path, std::ios::binary)
+{
+  if (!file) throw std::runtime_error("Failed to open " + path + " for recording");
+
+  if (y4m) writeY4MHeader(file, width, height, fps);
+
+  encoder = std::thread(&FrameRecorder::encoderLoop, this);
+}
+
+FrameRecorder::~FrameRecorder() { finish(); }
+
+/**
+ * Creates the pixel buffer objects, on the first GL capture.
+ */
+void FrameRecorder::setupRing()
+{
+  glGenBuffers(RingSize, PBOs);
+  for (GLuint pbo : PBOs)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  hasGL = true;
+}
+
+/**
+ * Starts reading back the current framebuffer, and hands the frame read two captures ago
+ * to the encoder. Call after drawing and before presenting.
+ */
+void FrameRecorder::capture()
+{
+  if (finished) return;
+  if (!hasGL) setupRing();
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, PBOs[nextPBO]);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  fences[nextPBO] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  nextPBO = (nextPBO + 1) % RingSize;
+  ++inFlight;
+
+  // Free the next slot: the oldest readback, started RingSize - 1 frames ago
+  if (inFlight == RingSize) collect(nextPBO);
+}
+
+/**
+ * Maps a finished readback and queues a copy for the encoder.
+ * @param index The ring slot.
+ */
+void FrameRecorder::collect(GLuint index)
+{
+  // Long done by now, so this normally returns at once
+  glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+  glDeleteSync(fences[index]);
+  fences[index] = nullptr;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, PBOs[index]);
+  const auto* pixels{static_cast<const unsigned char*>(
+      glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(width) * height * 4, GL_MAP_READ_BIT))};
+  if (pixels)
+  {
+    addFrame(pixels, true);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  --inFlight;
+}
+
+/**
+ * Queues a frame that is already in memory, e.g. from the software renderer.
+ * Blocks only when the encoder has fallen MaxQueuedFrames behind.
+ * @param rgba Tightly packed RGBA8 pixels, width * height of them.
+ * @param bottomUp Whether the first row is the bottom one (OpenGL read back).
+ */
+void FrameRecorder::addFrame(const unsigned char* rgba, bool bottomUp)
+{
+  std::vector<unsigned char> pixels{takeBuffer()};
+  std::memcpy(pixels.data(), rgba, pixels.size());
+
+  std::unique_lock<std::mutex> lock(mutex);
+  if (stopping) return;
+  drained.wait(lock, [this] { return queue.size() < MaxQueuedFrames; });
+  queue.push_back({std::move(pixels), bottomUp});
+  ++frameCount;
+  ready.notify_one();
+}
+
+/**
+ * Reuses a frame buffer the encoder is done with, so recording allocates nothing once warmed up.
+ */
+std::vector<unsigned char> FrameRecorder::takeBuffer()
+{
+  std::vector<unsigned char> buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!freeBuffers.empty())
+    {
+      buffer = std::move(freeBuffers.back());
+      freeBuffers.pop_back();
+    }
+  }
+  buffer.resize(static_cast<size_t>(width) * height * 4);
+  return buffer;
+}
+
+/**
+ * Frames read back and waiting for the encoder.
+ */
+size_t FrameRecorder::getQueuedFrames()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return queue.size();
+}
+
+/**
+ * Collects the readbacks still in flight, writes every queued frame and closes the file.
+ * Needs the GL context to still be current; safe to call more than once.
+ */
+void FrameRecorder::finish()
+{
+  if (finished) return;
+  finished = true;
+
+  if (hasGL)
+  {
+    for (GLuint index{(nextPBO + RingSize - inFlight) % RingSize}; inFlight > 0; index = (index + 1) % RingSize)
+    {
+      collect(index);
+    }
+    glDeleteBuffers(RingSize, PBOs);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  ready.notify_one();
+  encoder.join();
+
+  file.close();
+}
+
+/**
+ * Encoder thread: converts and writes queued frames until stopped and out of frames.
+ */
+void FrameRecorder::encoderLoop()
+{
+  while (true)
+  {
+    Frame frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [this] { return stopping || !queue.empty(); });
+      if (queue.empty()) return;
+
+      frame = std::move(queue.front());
+      queue.pop_front();
+    }
+    drained.notify_one();
+
+    if (y4m)
+    {
+      writeY4MFrame(file, width, height, frame.pixels.data(), frame.bottomUp);
+    }
+    else
+    {
+      writePPM(file, width, height, frame.pixels.data(), frame.bottomUp);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBuffers.push_back(std::move(frame.pixels));
+  }
+}
@@ -5,45 +5,93 @@
 #include <SFML/Window/Keyboard.hpp>
 #include <SFML/Window/Window.hpp>
 #include <SFML/Window/WindowEnums.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
 #include <iostream>
 #include <memory>
 #include <vector>
 
+#include "../include/gl_profiler.hpp"
 #include "../include/glad/glad.h"
 #include "../include/imgui/imgui.h"
+#include "../include/trace.hpp"
 
-Game::Game()
-    : gridSize(80),  // Square matrix
-      screenSize{sf::VideoMode::getDesktopMode().size.x / 2, sf::VideoMode::getDesktopMode().size.y / 2},
+/**
+ * Sets up a game and its window, or whatever the options draw to.
+ * @param options The launch options.
+ * @param shareWith A game made earlier with the same backend, whose programs, quad and atlas
+ * this one draws with rather than building its own; nullptr for the first or only game.
+ */
+Game::Game(const LaunchOptions& options, Game* shareWith)
+    : options(options),
+      gridSize(80),  // Square matrix
+      screenSize{options.getScreenSize()},
       gridInfo(gridSize, screenSize)
 {
-  // Setup window and OpenGL context
-  sf::ContextSettings settings;
-  settings.depthBits = 24;
-  settings.stencilBits = 8;
-  settings.majorVersion = 4;
-  settings.minorVersion = 4;
-  settings.attributeFlags = sf::ContextSettings::Core;
+  // A terminal board is as many cells as fit, its shorter side sets the grid
+  if (options.backend == Backend::Terminal)
+  {
+    gridSize = std::min(screenSize.first, screenSize.second);
+    gridInfo.updategridSize(gridSize);
+  }
+
+  // Setup window (or offscreen target) and OpenGL context, in the other game's share group
+  surface = Surface::create(options, screenSize, "SNAKE GAME", shareWith ? shareWith->surface.get() : nullptr);
 
-  sf::VideoMode desktopMode{sf::VideoMode::getDesktopMode()};
-  desktopMode.size.x = screenSize.first;
-  desktopMode.size.y = screenSize.second;
+  if (surface && shareWith && shareWith->resources)
+  {
+    // Nothing to compile or upload again
+    resources = shareWith->resources;
+  }
+  else if (surface)
+  {
+    // Let the driver compile shaders on its own threads where supported
+    Shader::enableParallelCompile(surface->getLoader());
 
-  window.create(desktopMode, "SNAKE GAME", sf::Style::Default, sf::State::Windowed, settings);
-  window.setFramerateLimit(60);
+    resources = std::make_shared<GLResources>();
+  }
 
-  if (!gladLoadGL())
+  if (!options.recordPath.empty())
   {
-    std::cerr << "Failed to initialize GLAD" << std::endl;
-    exit(1);
+    recorder = std::make_unique<FrameRecorder>(surface ? surface->getSize() : screenSize, options.recordPath);
   }
 
-  shaderProgram = std::make_unique<Shader>("../src/shaders/vertex.glsl", "../src/shaders/fragment.glsl");
-  snake = std::make_unique<Snake>(*shaderProgram, gridInfo);
-  food = std::make_unique<Food>(*shaderProgram, gridInfo);
-  gui = std::make_unique<GUI>();
-  renderEngine =
-      std::make_unique<RenderEngine>(window, *snake, *shaderProgram, *food, screenSize, gridInfo, *gui, this);
+  // Every run goes in the leaderboard; offscreen runs only keep one when asked to
+  const bool interactive{options.backend == Backend::Window || options.backend == Backend::Terminal};
+  const std::string leaderboardPath{!options.leaderboardPath.empty() ? options.leaderboardPath
+                                    : interactive                    ? Leaderboard::defaultPath()
+                                                                     : ""};
+  if (!leaderboardPath.empty()) leaderboard.open(leaderboardPath);
+  if (!options.telemetryPath.empty()) telemetry.open(options.telemetryPath);
+
+  // Game logic runs on its own thread from run() on
+  simulation = std::make_unique<Simulation>(resources ? resources->cellShader : placeholderShader, gridInfo,
+                                            options.inputDepth);
+
+  if (options.backend == Backend::Terminal)
+  {
+    terminalRenderer = std::make_unique<TerminalRenderer>(gridInfo);
+  }
+  else if (!surface)
+  {
+    softwareRenderer = std::make_unique<SoftwareRenderer>(screenSize, gridInfo);
+  }
+  else
+  {
+    gui = std::make_unique<GUI>();
+    renderEngine = std::make_unique<RenderEngine>(*surface, *resources, screenSize, gridInfo, *gui, this,
+                                                  options.guiRenderer);
+    renderEngine->setRecorder(recorder.get());
+  }
+
+  if (options.metricsPort)
+  {
+    metrics = std::make_unique<MetricsServer>(static_cast<uint16_t>(options.metricsPort),
+                                              [this](MetricsWriter& out) { writeMetrics(out); });
+  }
+  if (!renderEngine) return;
 
   // Attach event listener for controls
   renderEngine->addEventListener(
@@ -54,8 +102,12 @@ Game::Game()
           const auto* keyPressed{event.getIf<sf::Event::KeyPressed>()};
           if (isPlaying)
           {
-            // attach control to snake
-            snake->attachControl(*keyPressed);
+            // steer the snake, from the simulation's next tick on
+            const int direction{Snake::getKeyDirection(*keyPressed)};
+            if (direction >= 0)
+            {
+              simulation->send({CommandTurn, static_cast<GLfloat>(direction), renderEngine->getEventTime()});
+            }
           }
 
           if (!showGameOverWindow)
@@ -64,7 +116,7 @@ Game::Game()
             if (keyPressed->scancode == sf::Keyboard::Scan::Space ||
                 keyPressed->scancode == sf::Keyboard::Scan ::Escape)
             {
-              isPlaying = !isPlaying;
+              setPlaying(!isPlaying);
               showPauseMenuWindow = !isPlaying;
             }
           }
@@ -73,41 +125,101 @@ Game::Game()
           if (!isPlaying && keyPressed->scancode == sf::Keyboard::Scan::R)
           {
             resetGame();
-            isPlaying = !isPlaying;
+            setPlaying(!isPlaying);
             showPauseMenuWindow = !isPlaying;
           }
+
+          // Timings panel on F3, any time
+          if (keyPressed->scancode == sf::Keyboard::Scan::F3)
+          {
+            showTimingsWindow = !showTimingsWindow;
+            renderEngine->invalidate();
+          }
         }
       });
 }
 
+/**
+ * Tears down with this game's GL and ImGui contexts current; another game's may be.
+ */
+Game::~Game() { activate(); }
+
 ///// RUN THE GAME /////
 void Game::run()
 {
-  while (window.isOpen())
+  start();
+  while (isRunning()) frame(IdleTimeout);
+  finish();
+}
+
+/**
+ * Starts the simulation thread.
+ */
+void Game::start() { simulation->start(); }
+
+/**
+ * Makes this game's GL and ImGui contexts current, to draw it after another game.
+ */
+void Game::activate()
+{
+  if (surface) surface->setActive();
+  if (gui) gui->makeCurrent();
+}
+
+/**
+ * One pass of the game loop: draws a frame, or waits for input when nothing would change.
+ * @param idleTimeout Longest wait for a window event while paused.
+ */
+void Game::frame(sf::Time idleTimeout)
+{
+  // Paused or game over with no input: nothing changes on screen, sleep until something happens
+  if (renderEngine && !isPlaying && !renderEngine->isDamaged())
   {
-    // Game logic
-    if (isPlaying)
+    TRACE_SCOPE("idle");
+    renderEngine->waitEvents(idleTimeout);
+    return;
+  }
+
+  // Cells are drawn where they are, so the terminal only needs a look per key or tick
+  if (terminalRenderer)
+  {
+    TRACE_SCOPE("idle");
+    terminalRenderer->waitInput(TerminalPollMs);
+    for (TerminalKey key{terminalRenderer->readKey()}; key != KeyNone; key = terminalRenderer->readKey())
     {
-      GLuint snakeAction{snake->moveAndEat(*renderEngine, *food, bigFood)};
+      handleTerminalKey(key);
+    }
+    if (!isRunning()) return;
+  }
 
-      if (snakeAction == 1)
-      {
-        // std::cout << "💀 Game Over!\n";
+  TRACE_SCOPE("frame");
+  AllocScope allocations(frameAllocations);
+  TimingScope timing(frameTimes);
 
-        isPlaying = false;
-        showGameOverWindow = true;
-        showPauseMenuWindow = false;
-      }
-      else if (snakeAction == 2)
-      {
-        score++;
-      }
-      else if (snakeAction == 3)
-      {
-        score += 2;
-      }
+  // Pick up the newest state the simulation has published, if any
+  simulation->update();
+  const GameSnapshot& snapshot{simulation->read()};
+
+  // Snapshots from before a reset still describe the previous game
+  if (snapshot.round == round)
+  {
+    score = snapshot.score;
+
+    if (snapshot.gameOver && isPlaying)
+    {
+      // std::cout << "💀 Game Over!\n";
+
+      isPlaying = false;
+      recordRun(DeathCollision);
+      showGameOverWindow = true;
+      showPauseMenuWindow = false;
+      if (renderEngine) renderEngine->invalidate();
     }
+  }
 
+  // Render game
+  if (renderEngine)
+  {
     // Set transparency for HUD (not pause menu)
     if (!showPauseMenuWindow && !showGameOverWindow)
     {
@@ -119,27 +231,256 @@ void Game::run()
       ImGui::GetStyle().Alpha = 1.0f;
     }
 
-    // Render game
+    renderEngine->setSnapshot(&snapshot);
     renderEngine->render();
   }
+  else if (terminalRenderer)
+  {
+    TRACE_SCOPE("terminal render");
+    terminalRenderer->render(snapshot, formatTerminalStatus(snapshot));
+  }
+  else
+  {
+    TRACE_SCOPE("software render");
+    softwareRenderer->render(snapshot, snapshot.getMoveProgress(SimClock::now()));
+    if (recorder)
+    {
+      recorder->addFrame(reinterpret_cast<const unsigned char*>(softwareRenderer->getPixels().data()), false);
+    }
+  }
+
+  // Fixed-length runs (offscreen captures) stop here
+  if (options.frames && ++frameCount >= options.frames)
+  {
+    if (!options.outputPath.empty())
+    {
+      bool saved{surface ? surface->saveFrame(options.outputPath) : softwareRenderer->saveFrame(options.outputPath)};
+      if (!saved) std::cerr << "Failed to write " << options.outputPath << std::endl;
+    }
+    quit();
+  }
 }
 
 /**
- * Reset game
+ * Records the run and reports timings, once the loop is over.
  */
-void Game::resetGame()
+void Game::finish()
+{
+  // Quitting mid-game still counts as a run
+  recordRun(DeathQuit);
+
+  // Hand the terminal back first, the report would go to the alternate screen and vanish with it
+  terminalRenderer.reset();
+
+  // Real numbers to tune frame pacing and the input buffer with
+  if (renderEngine && renderEngine->getLatency().getCount() > 0) renderEngine->getLatency().report(std::cout);
+  if (frameTimes.getCount() > 0)
+  {
+    TimingHistogram::report(std::cout, "Timings",
+                            {{"tick", &simulation->getTickTimes()},
+                             {"frame", &frameTimes},
+                             {"imgui build", renderEngine ? &renderEngine->getImGuiBuildTimes() : nullptr},
+                             {"display", renderEngine ? &renderEngine->getDisplayTimes() : nullptr}});
+  }
+}
+
+/**
+ * Whether the game loop should keep going.
+ */
+bool Game::isRunning() const { return !Surface::isInterrupted() && (surface ? surface->isOpen() : running); }
+
+/**
+ * Best score so far: over every recorded run, or this session's without a leaderboard.
+ */
+GLuint Game::getHighScore() const { return std::max(highScore, leaderboard.getBest()); }
+
+/**
+ * Adds the current round to the leaderboard and the telemetry, once, unless it never got going.
+ * @param cause How the round ended.
+ */
+void Game::recordRun(DeathCause cause)
+{
+  const GameSnapshot& snapshot{simulation->read()};
+  if (runRecorded || snapshot.round != round || snapshot.tick == 0) return;
+
+  bestBeforeRun = getHighScore();
+  ++gamesFinished;
+  leaderboard.add(score, static_cast<uint32_t>(snapshot.snake.size()), snapshot.tick, Leaderboard::SourcePlayer);
+
+  if (telemetry.isOpen())
+  {
+    const auto [xMax, yMax]{gridInfo.getGridSizeI()};
+    GameRecord record;
+    record.endTime = static_cast<uint64_t>(std::time(nullptr));
+    record.seed = snapshot.seed;
+    record.agent = AgentPlayer;
+    record.gridWidth = static_cast<uint16_t>(xMax + 1);
+    record.gridHeight = static_cast<uint16_t>(yMax + 1);
+    record.difficulty = static_cast<uint8_t>(difficulty);
+    record.moveDelay = snapshot.moveDelay;
+    record.length = static_cast<uint32_t>(snapshot.snake.size());
+    record.score = score;
+    record.ticks = snapshot.tick;
+    record.deathCause = cause;
+    record.bigFoodHits = snapshot.bigFoodHits;
+    record.bigFoodMisses = snapshot.bigFoodMisses;
+    telemetry.add(record);
+  }
+  if (score > highScore) highScore = score;
+  runRecorded = true;
+}
+
+/**
+ * One scrape of the metrics endpoint, on its thread: throughput counters, how busy the
+ * simulation and render threads are, queue depths and timing percentiles.
+ * @param out The scrape.
+ */
+void Game::writeMetrics(MetricsWriter& out)
+{
+  const TimingHistogram& ticks{simulation->getTickTimes()};
+  out.counter("snake_games_total", "Games finished, however they ended.", static_cast<double>(gamesFinished.load()));
+  out.counter("snake_ticks_total", "Simulation ticks run.", static_cast<double>(ticks.getCount()));
+  out.counter("snake_frames_total", "Frames rendered.", static_cast<double>(frameTimes.getCount()));
+
+  // rate() of these is each thread's utilization
+  const TimingHistogram::Summary tickSummary{ticks.summarize()}, frameSummary{frameTimes.summarize()};
+  out.counter("snake_worker_busy_seconds_total", "Time a thread spent working rather than waiting.",
+              tickSummary.mean * tickSummary.count / 1000.0, "worker=\"simulation\"");
+  out.counter("snake_worker_busy_seconds_total", "", frameSummary.mean * frameSummary.count / 1000.0,
+              "worker=\"render\"");
+
+  out.gauge("snake_queue_depth", "Items waiting in a queue between threads.",
+            static_cast<double>(simulation->getCommandBacklog()), "queue=\"commands\"");
+  if (recorder)
+  {
+    out.gauge("snake_queue_depth", "", static_cast<double>(recorder->getQueuedFrames()), "queue=\"recorder\"");
+  }
+  if (telemetry.isOpen())
+  {
+    out.gauge("snake_queue_depth", "", static_cast<double>(telemetry.getPending()), "queue=\"telemetry\"");
+  }
+
+  out.summary("snake_tick_seconds", "Time to run a tick and publish its snapshot.", ticks);
+  out.summary("snake_frame_seconds", "Time to render a frame, display() included.", frameTimes);
+  if (renderEngine)
+  {
+    out.summary("snake_imgui_build_seconds", "Time to build a frame's ImGui windows.",
+                renderEngine->getImGuiBuildTimes());
+    out.summary("snake_display_seconds", "Time spent in display(), waiting for the swap.",
+                renderEngine->getDisplayTimes());
+  }
+
+  if (AllocTracker::Enabled) out.allocations({{"tick", &simulation->getTickAllocations()}, {"frame", &frameAllocations}});
+}
+
+/**
+ * Pauses or resumes the game; the simulation stops ticking while paused.
+ * @param playing Whether to play.
+ */
+void Game::setPlaying(bool playing)
+{
+  isPlaying = playing;
+  simulation->send({playing ? CommandResume : CommandPause});
+}
+
+/**
+ * Ends the game loop, closing the window if there is one.
+ */
+void Game::quit()
+{
+  running = false;
+  if (recorder) recorder->finish();
+  if (surface) surface->close();
+}
+
+/**
+ * Acts on a key pressed in the terminal, like the window's key listener and menus would.
+ * @param key The key.
+ */
+void Game::handleTerminalKey(TerminalKey key)
 {
-  // Update high score
-  if (score > highScore)
+  switch (key)
+  {
+    case KeyUp:
+    case KeyDown:
+    case KeyLeft:
+    case KeyRight:
+      if (isPlaying)
+      {
+        // Same directions as Snake::getKeyDirection
+        const GLfloat direction{key == KeyDown ? 0.0f : key == KeyRight ? 1.0f : key == KeyUp ? 2.0f : 3.0f};
+        simulation->send({CommandTurn, direction, SimClock::now()});
+      }
+      break;
+    case KeyPause:
+      if (!showGameOverWindow)
+      {
+        setPlaying(!isPlaying);
+        showPauseMenuWindow = !isPlaying;
+      }
+      break;
+    case KeyReset:
+      if (!isPlaying)
+      {
+        resetGame();
+        setPlaying(true);
+        showPauseMenuWindow = false;
+        showGameOverWindow = false;
+      }
+      break;
+    case KeyQuit:
+      quit();
+      break;
+    case KeyNone:
+      break;
+  }
+}
+
+/**
+ * The terminal's status line: score and length while playing, what the keys do when not.
+ * @param snapshot The state being drawn.
+ */
+std::string_view Game::formatTerminalStatus(const GameSnapshot& snapshot)
+{
+  char line[160];
+  if (showGameOverWindow)
+  {
+    std::snprintf(line, sizeof(line), " GAME OVER  Final score %u%s  Length %zu   r: play again  q: quit", score,
+                  score > bestBeforeRun ? " - new high score!" : "", snapshot.snake.size());
+  }
+  else if (!isPlaying)
   {
-    highScore = score;
-    score = 0;
+    std::snprintf(line, sizeof(line), " PAUSED  Score %u  High %u  Length %zu   space: resume  r: restart  q: quit",
+                  score, getHighScore(), snapshot.snake.size());
   }
+  else if (snapshot.bigFoodActive)
+  {
+    // In steps of 10%, so the line changes every few ticks rather than every tick
+    std::snprintf(line, sizeof(line), " Score %u  High %u  Length %zu   Big food %3d%%", score, getHighScore(),
+                  snapshot.snake.size(), static_cast<int>(std::ceil(snapshot.bigFoodLife * 10.0f)) * 10);
+  }
+  else
+  {
+    std::snprintf(line, sizeof(line), " Score %u  High %u  Length %zu   arrows/WASD: steer  space: pause  q: quit",
+                  score, getHighScore(), snapshot.snake.size());
+  }
+  terminalStatus.assign(line);
+  return terminalStatus;
+}
 
-  // Reset game objects
-  snake->reset();
-  food->reset();
-  if (bigFood->isActive) bigFood->reset();
+/**
+ * Reset game
+ */
+void Game::resetGame()
+{
+  // Keep the run, however it went
+  recordRun(DeathReset);
+  score = 0;
+
+  // Reset game objects, on the simulation thread
+  simulation->send({CommandReset});
+  ++round;
+  runRecorded = false;
 }
 
 void Game::showHUD()  // TODO: Treat these widgets as obstacles
@@ -151,7 +492,51 @@ void Game::showHUD()  // TODO: Treat these widgets as obstacles
   ImGui::Begin("Game Stats", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize);
   ImGui::Text("%s", isPlaying ? "# Playing" : "# Paused");
   ImGui::Separator();
-  ImGui::Text("Length: %zu", snake->getSegments().size());
+  ImGui::Text("Length: %zu", simulation->read().snake.size());
+  if (renderEngine && renderEngine->getLatency().getCount() > 0)
+  {
+    const auto& latency{renderEngine->getLatency().getShownSummary()};
+    ImGui::Text("Input lag: %.0f ms (p99 %.0f)", latency.p50, latency.p99);
+  }
+  if (AllocTracker::Enabled)
+  {
+    // Both should read 0 once the game is running; the peak shows what warming up took
+    const AllocCounter& ticks{simulation->getTickAllocations()};
+    ImGui::Text("Allocs/tick: %llu (peak %llu)", static_cast<unsigned long long>(ticks.last.load()),
+                static_cast<unsigned long long>(ticks.peak.load()));
+    ImGui::Text("Allocs/frame: %llu (peak %llu)", static_cast<unsigned long long>(frameAllocations.last.load()),
+                static_cast<unsigned long long>(frameAllocations.peak.load()));
+  }
+  if (GLProfiler::Enabled)
+  {
+    // GL calls of the last frame, then who made them
+    const GLCallCounts total{GLProfiler::getLastFrameTotal()};
+    ImGui::Separator();
+    ImGui::Text("GL: %u draws, %u uniforms, %u programs, %u VAOs", total.draws, total.uniforms, total.programBinds,
+                total.vaoBinds);
+    ImGui::Text("Transfers: %u uploads, %u reads, %.1f KB", total.uploads, total.readbacks, total.bytes / 1024.0);
+    if (ImGui::BeginTable("gl calls", 6, ImGuiTableFlags_SizingFixedFit))
+    {
+      for (const char* heading : {"", "draws", "unif", "binds", "xfers", "KB"}) ImGui::TableSetupColumn(heading);
+      ImGui::TableHeadersRow();
+      for (unsigned caller{0}; caller < CallerCount; ++caller)
+      {
+        const GLCallCounts& counts{GLProfiler::getLastFrame(static_cast<GLCaller>(caller))};
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(GLProfiler::getCallerName(static_cast<GLCaller>(caller)));
+        for (const uint32_t value : {counts.draws, counts.uniforms, counts.programBinds + counts.vaoBinds,
+                                     counts.uploads + counts.readbacks})
+        {
+          ImGui::TableNextColumn();
+          ImGui::Text("%u", value);
+        }
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", counts.bytes / 1024.0);
+      }
+      ImGui::EndTable();
+    }
+  }
   ImGui::End();
 
   // === HUD: Score (top-right) ===
@@ -161,7 +546,47 @@ void Game::showHUD()  // TODO: Treat these widgets as obstacles
   ImGui::Begin("Score", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize);
   ImGui::Text("Score: %d", score);
   ImGui::Separator();
-  ImGui::Text("High score: %d", highScore);  // TODO: Implement highscore persistent storing and retrieval feature
+  ImGui::Text("High score: %d", getHighScore());
+  ImGui::End();
+}
+
+/**
+ * Debug panel (F3, bottom-left): percentiles of tick, frame, UI build and display() times.
+ */
+void Game::showTimings()
+{
+  if (!showTimingsWindow) return;
+
+  ImGui::SetNextWindowPos(ImVec2(10.0f, ImGui::GetIO().DisplaySize.y - 10.0f), ImGuiCond_Always, ImVec2(0.0f, 1.0f));
+  ImGui::Begin("Timings", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::Text("Timings (ms)");
+  ImGui::Separator();
+
+  if (ImGui::BeginTable("timings", 5, ImGuiTableFlags_SizingFixedFit))
+  {
+    for (const char* heading : {"", "p50", "p99", "p99.9", "max"}) ImGui::TableSetupColumn(heading);
+    ImGui::TableHeadersRow();
+
+    const std::pair<const char*, const TimingHistogram*> rows[]{
+        {"Tick", &simulation->getTickTimes()},
+        {"Frame", &frameTimes},
+        {"ImGui build", &renderEngine->getImGuiBuildTimes()},
+        {"Display", &renderEngine->getDisplayTimes()},
+    };
+    for (const auto& [name, histogram] : rows)
+    {
+      const TimingHistogram::Summary summary{histogram->summarize()};
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name);
+      for (const double value : {summary.p50, summary.p99, summary.p999, summary.max})
+      {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", value);
+      }
+    }
+    ImGui::EndTable();
+  }
   ImGui::End();
 }
 
@@ -172,7 +597,7 @@ void Game::showPauseMenu()
   // Center the window
   ImVec2 center{ImVec2(ImGui::GetIO().DisplaySize.x * 0.5f, ImGui::GetIO().DisplaySize.y * 0.5f)};
   ImGui::SetNextWindowPos(center, ImGuiCond_Always, ImVec2(0.5f, 0.5f));
-  ImGui::SetNextWindowSize(ImVec2(400, 500), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(400, 620), ImGuiCond_FirstUseEver);
 
   ImGui::Begin("- GAME PAUSED", &showPauseMenuWindow, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize);
 
@@ -181,14 +606,39 @@ void Game::showPauseMenu()
   ImGui::Spacing();
 
   // === GAME STATS ===
-  ImGui::Text("- Snake Length: %zu", snake->getSegments().size());
+  ImGui::Text("- Snake Length: %zu", simulation->read().snake.size());
   ImGui::Text("- Score: %d", score);
-  ImGui::Text("- High Score: %d", highScore);
+  ImGui::Text("- High Score: %d", getHighScore());
 
   ImGui::Spacing();
   ImGui::Separator();
   ImGui::Spacing();
 
+  // === LEADERBOARD ===
+  if (leaderboard.isOpen())
+  {
+    ImGui::Text("-  Leaderboard");
+    ImGui::Spacing();
+    if (!leaderboard.isLoaded())
+    {
+      ImGui::TextDisabled("Loading...");
+    }
+    for (size_t rank{0}; rank < std::min<size_t>(leaderboard.getTopCount(), 5); ++rank)
+    {
+      const Leaderboard::Record run{leaderboard.getTop(rank)};
+      char date[32];
+      const std::time_t time{static_cast<std::time_t>(run.time)};
+      std::strftime(date, sizeof(date), "%Y-%m-%d", std::localtime(&time));
+      ImGui::Text("%zu. %5u  length %4u  %s%s", rank + 1, run.score, run.length, date,
+                  run.source == Leaderboard::SourceBot ? "  (bot)" : "");
+    }
+    ImGui::TextDisabled("%zu runs", leaderboard.getRunCount());
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+  }
+
   // === DIFFICULTY SETTINGS ===
   ImGui::Text("-  Game Settings");
   ImGui::Spacing();
@@ -214,14 +664,14 @@ void Game::showPauseMenu()
       case 4:
         break;  // Custom
     }
-    snake->setMoveDelay(snakeSpeed);
+    simulation->send({CommandSetMoveDelay, snakeSpeed});
   }
 
   // Custom speed slider
   ImGui::Text("Snake Speed");
   if (ImGui::SliderFloat("##speed", &snakeSpeed, 0.05f, 0.3f, "%.2fs"))
   {
-    snake->setMoveDelay(snakeSpeed);
+    simulation->send({CommandSetMoveDelay, snakeSpeed});
     difficulty = 4;  // Custom speed
   }
   ImGui::SameLine();
@@ -252,7 +702,7 @@ void Game::showPauseMenu()
 
   if (ImGui::Button("Resume Game", ImVec2(-1, 40)))
   {
-    isPlaying = true;
+    setPlaying(true);
     showPauseMenuWindow = false;
   }
   ImGui::PopStyleColor(3);
@@ -266,7 +716,7 @@ void Game::showPauseMenu()
   if (ImGui::Button("Reset Game", ImVec2(-1, 40)))
   {
     resetGame();
-    isPlaying = true;
+    setPlaying(true);
     showPauseMenuWindow = false;
   }
   ImGui::PopStyleColor(3);
@@ -279,7 +729,7 @@ void Game::showPauseMenu()
 
   if (ImGui::Button("x Quit Game", ImVec2(-1, 40)))
   {
-    window.close();
+    quit();
   }
 
   ImGui::PopStyleColor(3);
@@ -336,7 +786,7 @@ void Game::showGameOverMenu()
   ImGui::Spacing();
 
   // === HIGH SCORE DISPLAY ===
-  bool isNewHighScore = score > highScore;
+  bool isNewHighScore = score > bestBeforeRun;
 
   if (isNewHighScore)
   {
@@ -350,7 +800,7 @@ void Game::showGameOverMenu()
   else
   {
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-    snprintf(scoreText, sizeof(scoreText), "High Score: %d", highScore);
+    snprintf(scoreText, sizeof(scoreText), "High Score: %d", getHighScore());
     textSize = ImGui::CalcTextSize(scoreText);
     ImGui::SetCursorPosX((ImGui::GetWindowSize().x - textSize.x) * 0.5f);
     ImGui::Text("%s", scoreText);
@@ -363,7 +813,7 @@ void Game::showGameOverMenu()
   // === STATS ===
   ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.8f, 0.8f, 0.8f, 1.0f));
 
-  snprintf(scoreText, sizeof(scoreText), "- Final Length: %zu", snake->getSegments().size());
+  snprintf(scoreText, sizeof(scoreText), "- Final Length: %zu", simulation->read().snake.size());
   textSize = ImGui::CalcTextSize(scoreText);
   ImGui::SetCursorPosX((ImGui::GetWindowSize().x - textSize.x) * 0.5f);
   ImGui::Text("%s", scoreText);
@@ -405,7 +855,7 @@ void Game::showGameOverMenu()
   if (ImGui::Button("> Play Again", ImVec2(buttonWidth, 50)))
   {
     resetGame();
-    isPlaying = true;
+    setPlaying(true);
     showGameOverWindow = false;
   }
 
@@ -441,7 +891,7 @@ void Game::showGameOverMenu()
 
   if (ImGui::Button("x Quit Game", ImVec2(buttonWidth, 50)))
   {
-    window.close();
+    quit();
   }
 
   ImGui::PopStyleVar();
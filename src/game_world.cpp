@@ -0,0 +1,37 @@
+#include "../include/game_world.hpp"
+
+GameWorld::GameWorld(Shader& shader, const GridInfo& gridInfo, Arena& arena, uint32_t seed)
+    : seed(seed),
+      random(seed),
+      snake(shader, gridInfo, &arena, &random),
+      food(shader, gridInfo, false, &arena, &random),
+      bigFood(shader, gridInfo, &arena, &random)
+{
+}
+
+/**
+ * Starts a new game: rewinds the arena and builds a world at its start. The previous world's
+ * destructors don't run; all it held was arena memory, which the rewind already took back.
+ * @param arena The game's arena, at least footprint() bytes.
+ * @param shader Program the objects are drawn with.
+ * @param gridInfo Grid the game is played on.
+ * @param seed Seed of everything random in the game.
+ * @return The new world, valid until the next create().
+ */
+GameWorld& GameWorld::create(Arena& arena, Shader& shader, const GridInfo& gridInfo, uint32_t seed)
+{
+  arena.reset();
+  return *arena.create<GameWorld>(shader, gridInfo, arena, seed);
+}
+
+/**
+ * Arena size a world on this grid needs: the objects, and their cells at their largest,
+ * a snake filling the grid (twice, with the previous move) and 4 cells for each food.
+ * @param gridInfo Grid the game is played on.
+ */
+size_t GameWorld::footprint(const GridInfo& gridInfo)
+{
+  const size_t snakeCells{gridInfo.getCellCount() * sizeof(Cell)};
+  const size_t foodCells{4 * sizeof(Cell)};
+  return Arena::footprint(sizeof(GameWorld)) + 2 * Arena::footprint(snakeCells) + 2 * Arena::footprint(foodCells);
+}
@@ -0,0 +1,288 @@
+#include "../include/gl_profiler.hpp"
+
+#include <array>
+
+#include "../include/glad/glad.h"
+
+namespace
+{
+std::array<GLCallCounts, CallerCount> frameCounts{};  // the frame being drawn
+std::array<GLCallCounts, CallerCount> lastCounts{};   // the last finished frame
+GLCaller currentCaller{CallerOther};
+
+const char* const CallerNames[CallerCount]{"Other", "Cells", "ImGui", "Recorder"};
+}  // namespace
+
+GLCallCounts& GLCallCounts::operator+=(const GLCallCounts& other)
+{
+  draws += other.draws;
+  uniforms += other.uniforms;
+  programBinds += other.programBinds;
+  vaoBinds += other.vaoBinds;
+  uploads += other.uploads;
+  readbacks += other.readbacks;
+  bytes += other.bytes;
+  return *this;
+}
+
+/**
+ * Makes the current frame's counts the last frame's, and starts counting the next one.
+ * Call once per frame, after presenting it.
+ */
+void GLProfiler::endFrame()
+{
+  lastCounts = frameCounts;
+  frameCounts = {};
+}
+
+/**
+ * @return The caller the calls were attributed to until now.
+ */
+GLCaller GLProfiler::setCaller(GLCaller caller)
+{
+  const GLCaller previous{currentCaller};
+  currentCaller = caller;
+  return previous;
+}
+
+const GLCallCounts& GLProfiler::getLastFrame(GLCaller caller) { return lastCounts[caller]; }
+
+GLCallCounts GLProfiler::getLastFrameTotal()
+{
+  GLCallCounts total;
+  for (const GLCallCounts& counts : lastCounts) total += counts;
+  return total;
+}
+
+const char* GLProfiler::getCallerName(GLCaller caller) { return CallerNames[caller]; }
+
+#ifdef SNAKE_GL_PROFILE
+namespace
+{
+GLCallCounts& counts() { return frameCounts[currentCaller]; }
+
+/**
+ * Size of the pixels of a texture upload or read back, from its format and type.
+ */
+uint64_t imageBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+  uint64_t channels{4};
+  switch (format)
+  {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+      channels = 1;
+      break;
+    case GL_RG:
+    case GL_RG_INTEGER:
+      channels = 2;
+      break;
+    case GL_RGB:
+    case GL_BGR:
+      channels = 3;
+      break;
+  }
+
+  uint64_t channelBytes{1};
+  switch (type)
+  {
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+      channelBytes = 2;
+      break;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      channelBytes = 4;
+      break;
+  }
+
+  return static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * channels * channelBytes;
+}
+
+// The driver's entry points, as glad loaded them
+PFNGLDRAWELEMENTSPROC realDrawElements;
+PFNGLDRAWELEMENTSBASEVERTEXPROC realDrawElementsBaseVertex;
+PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC realDrawElementsInstancedBaseInstance;
+PFNGLDRAWARRAYSPROC realDrawArrays;
+PFNGLUNIFORM1IPROC realUniform1i;
+PFNGLUNIFORM1FPROC realUniform1f;
+PFNGLUNIFORM2FPROC realUniform2f;
+PFNGLUNIFORM4FPROC realUniform4f;
+PFNGLUNIFORMMATRIX4FVPROC realUniformMatrix4fv;
+PFNGLUSEPROGRAMPROC realUseProgram;
+PFNGLBINDVERTEXARRAYPROC realBindVertexArray;
+PFNGLBUFFERDATAPROC realBufferData;
+PFNGLBUFFERSUBDATAPROC realBufferSubData;
+PFNGLMAPBUFFERRANGEPROC realMapBufferRange;
+PFNGLTEXIMAGE2DPROC realTexImage2D;
+PFNGLTEXSUBIMAGE2DPROC realTexSubImage2D;
+PFNGLREADPIXELSPROC realReadPixels;
+
+void APIENTRY countedDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+  ++counts().draws;
+  realDrawElements(mode, count, type, indices);
+}
+
+void APIENTRY countedDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                            GLint baseVertex)
+{
+  ++counts().draws;
+  realDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+}
+
+void APIENTRY countedDrawElementsInstancedBaseInstance(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                                       GLsizei instances, GLuint baseInstance)
+{
+  ++counts().draws;
+  realDrawElementsInstancedBaseInstance(mode, count, type, indices, instances, baseInstance);
+}
+
+void APIENTRY countedDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+  ++counts().draws;
+  realDrawArrays(mode, first, count);
+}
+
+void APIENTRY countedUniform1i(GLint location, GLint v0)
+{
+  ++counts().uniforms;
+  realUniform1i(location, v0);
+}
+
+void APIENTRY countedUniform1f(GLint location, GLfloat v0)
+{
+  ++counts().uniforms;
+  realUniform1f(location, v0);
+}
+
+void APIENTRY countedUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+  ++counts().uniforms;
+  realUniform2f(location, v0, v1);
+}
+
+void APIENTRY countedUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+  ++counts().uniforms;
+  realUniform4f(location, v0, v1, v2, v3);
+}
+
+void APIENTRY countedUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+  ++counts().uniforms;
+  realUniformMatrix4fv(location, count, transpose, value);
+}
+
+void APIENTRY countedUseProgram(GLuint program)
+{
+  ++counts().programBinds;
+  realUseProgram(program);
+}
+
+void APIENTRY countedBindVertexArray(GLuint array)
+{
+  ++counts().vaoBinds;
+  realBindVertexArray(array);
+}
+
+void APIENTRY countedBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+  // Without data it only allocates storage, nothing is transferred
+  if (data)
+  {
+    ++counts().uploads;
+    counts().bytes += static_cast<uint64_t>(size);
+  }
+  realBufferData(target, size, data, usage);
+}
+
+void APIENTRY countedBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+  ++counts().uploads;
+  counts().bytes += static_cast<uint64_t>(size);
+  realBufferSubData(target, offset, size, data);
+}
+
+void* APIENTRY countedMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+  // Mapped for reading, the bytes were already counted by the glReadPixels filling the buffer
+  if (access & GL_MAP_WRITE_BIT)
+  {
+    ++counts().uploads;
+    counts().bytes += static_cast<uint64_t>(length);
+  }
+  return realMapBufferRange(target, offset, length, access);
+}
+
+void APIENTRY countedTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                                GLint border, GLenum format, GLenum type, const void* pixels)
+{
+  if (pixels)
+  {
+    ++counts().uploads;
+    counts().bytes += imageBytes(width, height, format, type);
+  }
+  realTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+void APIENTRY countedTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+                                   GLenum format, GLenum type, const void* pixels)
+{
+  ++counts().uploads;
+  counts().bytes += imageBytes(width, height, format, type);
+  realTexSubImage2D(target, level, x, y, width, height, format, type, pixels);
+}
+
+void APIENTRY countedReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                                void* pixels)
+{
+  ++counts().readbacks;
+  counts().bytes += imageBytes(width, height, format, type);
+  realReadPixels(x, y, width, height, format, type, pixels);
+}
+
+/**
+ * Points a glad entry point at its counting wrapper, keeping the driver's to forward to.
+ * Hooking twice would make the wrapper forward to itself, so a hooked one is left alone.
+ */
+template <typename Proc>
+void hook(Proc& entry, Proc& real, Proc counted)
+{
+  if (!entry || entry == counted) return;
+  real = entry;
+  entry = counted;
+}
+}  // namespace
+
+/**
+ * Routes the counted GL calls through the profiler. Call after every successful glad load,
+ * since loading resets the entry points to the driver's.
+ */
+void GLProfiler::install()
+{
+  hook(glad_glDrawElements, realDrawElements, countedDrawElements);
+  hook(glad_glDrawElementsBaseVertex, realDrawElementsBaseVertex, countedDrawElementsBaseVertex);
+  hook(glad_glDrawElementsInstancedBaseInstance, realDrawElementsInstancedBaseInstance,
+       countedDrawElementsInstancedBaseInstance);
+  hook(glad_glDrawArrays, realDrawArrays, countedDrawArrays);
+  hook(glad_glUniform1i, realUniform1i, countedUniform1i);
+  hook(glad_glUniform1f, realUniform1f, countedUniform1f);
+  hook(glad_glUniform2f, realUniform2f, countedUniform2f);
+  hook(glad_glUniform4f, realUniform4f, countedUniform4f);
+  hook(glad_glUniformMatrix4fv, realUniformMatrix4fv, countedUniformMatrix4fv);
+  hook(glad_glUseProgram, realUseProgram, countedUseProgram);
+  hook(glad_glBindVertexArray, realBindVertexArray, countedBindVertexArray);
+  hook(glad_glBufferData, realBufferData, countedBufferData);
+  hook(glad_glBufferSubData, realBufferSubData, countedBufferSubData);
+  hook(glad_glMapBufferRange, realMapBufferRange, countedMapBufferRange);
+  hook(glad_glTexImage2D, realTexImage2D, countedTexImage2D);
+  hook(glad_glTexSubImage2D, realTexSubImage2D, countedTexSubImage2D);
+  hook(glad_glReadPixels, realReadPixels, countedReadPixels);
+}
+#else
+void GLProfiler::install() {}
+#endif
@@ -0,0 +1,21 @@
+#include "../include/gl_resources.hpp"
+
+#include "embedded_shaders.hpp"
+
+/**
+ * Builds the cell program and the quad in the current context.
+ */
+GLResources::GLResources() : cellShader(ShaderSource::load(), Shader::defaultCacheDir()) { quad.create(); }
+
+/**
+ * The program ImGuiRingRenderer draws with, built the first time a ring asks for it.
+ */
+Shader& GLResources::getImGuiShader()
+{
+  if (!imguiShader)
+  {
+    imguiShader = std::make_unique<Shader>(ShaderSource{EmbeddedShaders::imgui_vertex, EmbeddedShaders::imgui_fragment},
+                                           Shader::defaultCacheDir());
+  }
+  return *imguiShader;
+}
@@ -0,0 +1,106 @@
+#include "../include/gl_state_cache.hpp"
+
+/**
+ * Forgets every binding, so the next call of each kind goes to GL.
+ * Call after GL state was changed without the cache, or objects it may hold were deleted.
+ */
+void GLStateCache::invalidate()
+{
+  program = vao = Unknown;
+  arrayBuffer = pixelPackBuffer = pixelUnpackBuffer = Unknown;
+  unit = Unknown;
+  textures.fill(Unknown);
+  blend = Unknown;
+  blendSource = blendDestination = Unknown;
+}
+
+bool GLStateCache::useProgram(GLuint program)
+{
+  if (this->program == program) return false;
+  this->program = program;
+  glUseProgram(program);
+  return true;
+}
+
+bool GLStateCache::bindVertexArray(GLuint vao)
+{
+  if (this->vao == vao) return false;
+  this->vao = vao;
+  glBindVertexArray(vao);
+  return true;
+}
+
+/**
+ * Where the binding of a buffer target is kept, or null for targets that are not cached.
+ * GL_ELEMENT_ARRAY_BUFFER belongs to the bound VAO, so it is never cached.
+ */
+GLuint* GLStateCache::bufferSlot(GLenum target)
+{
+  switch (target)
+  {
+    case GL_ARRAY_BUFFER:
+      return &arrayBuffer;
+    case GL_PIXEL_PACK_BUFFER:
+      return &pixelPackBuffer;
+    case GL_PIXEL_UNPACK_BUFFER:
+      return &pixelUnpackBuffer;
+    default:
+      return nullptr;
+  }
+}
+
+bool GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+  GLuint* bound{bufferSlot(target)};
+  if (bound)
+  {
+    if (*bound == buffer) return false;
+    *bound = buffer;
+  }
+  glBindBuffer(target, buffer);
+  return true;
+}
+
+/**
+ * @param unit GL_TEXTURE0 + n.
+ */
+bool GLStateCache::activeTexture(GLenum unit)
+{
+  const GLuint index{unit - GL_TEXTURE0};
+  if (this->unit == index) return false;
+  this->unit = index;
+  glActiveTexture(unit);
+  return true;
+}
+
+/**
+ * Binds a texture to the active unit. Only GL_TEXTURE_2D is cached, and only once the active
+ * unit is known.
+ */
+bool GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+  if (target == GL_TEXTURE_2D && unit < TextureUnits)
+  {
+    if (textures[unit] == texture) return false;
+    textures[unit] = texture;
+  }
+  glBindTexture(target, texture);
+  return true;
+}
+
+bool GLStateCache::setBlend(bool enabled)
+{
+  if (blend == static_cast<GLuint>(enabled)) return false;
+  blend = enabled;
+  enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+  return true;
+}
+
+bool GLStateCache::blendFunc(GLenum source, GLenum destination)
+{
+  if (blendSource == source && blendDestination == destination) return false;
+  blendSource = source;
+  blendDestination = destination;
+  glBlendFunc(source, destination);
+  return true;
+}
@@ -7,35 +7,104 @@
 #include "../include/imgui/imgui_impl_sfml.h"
 
 GUI::GUI() {}
-GUI::~GUI() {}
 
-void GUI::init(sf::Window& window)
+// Without shutdown() the GL context is already gone, and the ring's objects with it
+GUI::~GUI()
+{
+  if (ring) ring->abandon();
+}
+
+/**
+ * Creates the ImGui context and its backends, and leaves the context current.
+ * @param surface What ImGui draws to; its window, if any, feeds ImGui input.
+ * @param state The GL state cache of the surface's context.
+ * @param resources Objects shared between contexts, the ring's program among them.
+ * @param renderer How to draw; the ring needs GL 4.4 and falls back to the stock backend without it.
+ */
+void GUI::init(Surface& surface, GLStateCache& state, GLResources& resources, GUIRenderer renderer)
 {
   IMGUI_CHECKVERSION();
-  ImGui::CreateContext();
+  context = ImGui::CreateContext();
+  makeCurrent();
 
   // Setup style
   ImGui::StyleColorsDark();
 
-  // Initialize backends
-  ImGui::SFML::Init(window);
+  // Initialize backends, offscreen surfaces have no SFML window to feed ImGui
+  if (sf::Window* window{surface.getWindow()})
+  {
+    ImGui::SFML::Init(*window);
+  }
+  else
+  {
+    auto [width, height]{surface.getSize()};
+    ImGui::GetIO().DisplaySize = ImVec2(static_cast<float>(width), static_cast<float>(height));
+  }
+  // The stock backend creates and updates the textures in either case
   ImGui_ImplOpenGL3_Init("#version 440");
+
+  if (renderer == GUIRenderer::Ring && ImGuiRingRenderer::isSupported())
+  {
+    ring = std::make_unique<ImGuiRingRenderer>(state, resources.getImGuiShader());
+  }
+  else
+  {
+    // Build ImGui's shaders now rather than on the first frame
+    ImGui_ImplOpenGL3_CreateDeviceObjects();
+  }
 }
 
 void GUI::shutdown()
 {
+  makeCurrent();
+  ring.reset();
   ImGui_ImplOpenGL3_Shutdown();
   ImGui::SFML::Shutdown();
-  ImGui::DestroyContext();
+  ImGui::DestroyContext(context);
+  context = nullptr;
 }
 
-void GUI::beginFrame(sf::Window& window, sf::Time deltaTime)
+/**
+ * Makes this GUI's context the one ImGui calls go to, until another GUI's is made current.
+ */
+void GUI::makeCurrent() const { ImGui::SetCurrentContext(context); }
+
+/**
+ * Feeds a window event to ImGui.
+ */
+void GUI::processEvent(const sf::Event& event) const
 {
-  ImGui::SFML::Update(window, deltaTime);
-  ImGui_ImplOpenGL3_NewFrame();
+  makeCurrent();
+  ImGui::SFML::ProcessEvent(event);
 }
+
+void GUI::beginFrame(Surface& surface, sf::Time deltaTime)
+{
+  makeCurrent();
+  if (sf::Window* window{surface.getWindow()})
+  {
+    ImGui::SFML::Update(*window, deltaTime);
+  }
+  else
+  {
+    ImGuiIO& io{ImGui::GetIO()};
+    io.DeltaTime = deltaTime.asSeconds() > 0.0f ? deltaTime.asSeconds() : 1.0f / 60.0f;
+    ImGui::NewFrame();
+  }
+  // Only the stock backend has device objects to create lazily
+  if (!ring) ImGui_ImplOpenGL3_NewFrame();
+}
+
 void GUI::endFrame()
 {
+  makeCurrent();
   ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  if (ring)
+  {
+    ring->render(ImGui::GetDrawData());
+  }
+  else
+  {
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  }
 }
@@ -0,0 +1,188 @@
+#include "../include/headless_surface.hpp"
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include "../include/gl_profiler.hpp"
+#include "../include/glad/glad.h"
+
+static bool hasExtension(const char* extensions, const char* name)
+{
+  if (!extensions) return false;
+
+  const size_t length{std::strlen(name)};
+  for (const char* it{std::strstr(extensions, name)}; it; it = std::strstr(it + 1, name))
+  {
+    const bool starts{it == extensions || it[-1] == ' '};
+    const bool ends{it[length] == ' ' || it[length] == '\0'};
+    if (starts && ends) return true;
+  }
+  return false;
+}
+
+/**
+ * Picks an EGL display that needs no window system.
+ * Prefers Mesa's surfaceless platform, then falls back to the default display.
+ */
+static EGLDisplay getHeadlessDisplay()
+{
+  const char* clientExtensions{eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS)};
+
+  if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+  {
+    auto getPlatformDisplay{
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"))};
+    if (getPlatformDisplay)
+    {
+      EGLDisplay display{getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr)};
+      if (display != EGL_NO_DISPLAY) return display;
+    }
+  }
+
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+// Surfaces using the display, which is terminated with the last of them
+static unsigned displayUsers{0};
+
+/**
+ * Creates an OpenGL 4.4 core context without any window and makes it current.
+ * @param size The framebuffer dimensions (width, height).
+ * @param share A surface whose context shares its programs, buffers and textures with this
+ * one, or nullptr.
+ */
+HeadlessSurface::HeadlessSurface(const ScreenSize& size, const HeadlessSurface* share) : size(size)
+{
+  // Contexts can only share objects on the same display
+  if (share)
+  {
+    eglDisplay = share->eglDisplay;
+    eglConfig = share->eglConfig;
+  }
+  else
+  {
+    initializeDisplay();
+  }
+
+  // The surfaceless platform exposes no configs at all, which is fine with EGL_KHR_no_config_context
+  const char* extensions{eglQueryString(eglDisplay, EGL_EXTENSIONS)};
+  const bool surfaceless{hasExtension(extensions, "EGL_KHR_surfaceless_context")};
+
+  if (!surfaceless)
+  {
+    if (!eglConfig) throw std::runtime_error("No EGL config for a pbuffer surface");
+
+    const EGLint pbufferAttribs[]{EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    pbuffer = eglCreatePbufferSurface(eglDisplay, eglConfig, pbufferAttribs);
+  }
+
+  const EGLint contextAttribs[]{EGL_CONTEXT_MAJOR_VERSION,
+                                4,
+                                EGL_CONTEXT_MINOR_VERSION,
+                                4,
+                                EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                EGL_NONE};
+  eglContext = eglCreateContext(eglDisplay, eglConfig ? eglConfig : EGL_NO_CONFIG_KHR,
+                                share ? share->eglContext : EGL_NO_CONTEXT, contextAttribs);
+  if (eglContext == EGL_NO_CONTEXT)
+  {
+    throw std::runtime_error("Failed to create an OpenGL 4.4 core EGL context");
+  }
+
+  if (!setActive())
+  {
+    throw std::runtime_error("Failed to make the EGL context current");
+  }
+
+  if (!gladLoadGLLoader(getLoader()))
+  {
+    throw std::runtime_error("Failed to initialize GLAD");
+  }
+  GLProfiler::install();
+
+  setupFramebuffer();
+  ++displayUsers;
+}
+
+HeadlessSurface::~HeadlessSurface()
+{
+  // The framebuffer belongs to this context, which may not be the current one
+  setActive();
+  glDeleteFramebuffers(1, &FBO);
+  glDeleteRenderbuffers(1, &colorRBO);
+  glDeleteRenderbuffers(1, &depthRBO);
+
+  eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroyContext(eglDisplay, eglContext);
+  if (pbuffer != EGL_NO_SURFACE) eglDestroySurface(eglDisplay, pbuffer);
+  if (--displayUsers == 0) eglTerminate(eglDisplay);
+}
+
+/**
+ * Opens the EGL display for desktop OpenGL, and picks a pbuffer config if it has any.
+ */
+void HeadlessSurface::initializeDisplay()
+{
+  eglDisplay = getHeadlessDisplay();
+  if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+  {
+    throw std::runtime_error("Failed to initialize EGL display");
+  }
+
+  if (!eglBindAPI(EGL_OPENGL_API))
+  {
+    throw std::runtime_error("EGL display does not support desktop OpenGL");
+  }
+
+  const EGLint configAttribs[]{EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLConfig config{nullptr};
+  EGLint configCount{0};
+  eglChooseConfig(eglDisplay, configAttribs, &config, 1, &configCount);
+  if (configCount) eglConfig = config;
+}
+
+/**
+ * Makes this surface's context current, drawing into its framebuffer (bound since creation).
+ */
+bool HeadlessSurface::setActive() { return eglMakeCurrent(eglDisplay, pbuffer, pbuffer, eglContext); }
+
+/**
+ * Creates the framebuffer object everything is drawn into, and leaves it bound.
+ * Mirrors the window's default framebuffer: RGBA8 color with 24-bit depth and 8-bit stencil.
+ */
+void HeadlessSurface::setupFramebuffer()
+{
+  glGenFramebuffers(1, &FBO);
+  glGenRenderbuffers(1, &colorRBO);
+  glGenRenderbuffers(1, &depthRBO);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.first, size.second);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size.first, size.second);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+  {
+    throw std::runtime_error("Headless framebuffer is incomplete");
+  }
+
+  glViewport(0, 0, size.first, size.second);
+}
+
+/**
+ * Nothing to present offscreen; just make sure the frame's commands are submitted.
+ */
+void HeadlessSurface::display() { glFlush(); }
+
+GLADloadproc HeadlessSurface::getLoader() const
+{
+  return [](const char* name) { return reinterpret_cast<void*>(eglGetProcAddress(name)); };
+}
@@ -0,0 +1,87 @@
+#include "../include/image.hpp"
+
+#include <fstream>
+#include <vector>
+
+/**
+ * Writes an RGBA8 image as a binary PPM.
+ * @param path The file to write.
+ * @param width Image width in pixels.
+ * @param height Image height in pixels.
+ * @param rgba Tightly packed RGBA8 pixels.
+ * @param bottomUp Whether the first row in memory is the bottom one (OpenGL read back).
+ * @return True on success.
+ */
+bool writePPM(const std::string& path, GLuint width, GLuint height, const unsigned char* rgba, bool bottomUp)
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file) return false;
+
+  writePPM(file, width, height, rgba, bottomUp);
+  return static_cast<bool>(file);
+}
+
+/**
+ * Writes an RGBA8 image as a binary PPM to a stream.
+ * PPM images can simply be concatenated, which makes a lossless video stream.
+ */
+void writePPM(std::ostream& out, GLuint width, GLuint height, const unsigned char* rgba, bool bottomUp)
+{
+  out << "P6\n" << width << " " << height << "\n255\n";
+
+  std::vector<unsigned char> row(static_cast<size_t>(width) * 3);
+  for (GLuint y{0}; y < height; ++y)
+  {
+    const unsigned char* src{rgba + static_cast<size_t>(bottomUp ? height - 1 - y : y) * width * 4};
+    for (GLuint x{0}; x < width; ++x)
+    {
+      row[x * 3 + 0] = src[x * 4 + 0];
+      row[x * 3 + 1] = src[x * 4 + 1];
+      row[x * 3 + 2] = src[x * 4 + 2];
+    }
+    out.write(reinterpret_cast<const char*>(row.data()), row.size());
+  }
+}
+
+/**
+ * Writes the stream header of a Y4M video.
+ * @param fps Frame rate the video plays back at.
+ */
+void writeY4MHeader(std::ostream& out, GLuint width, GLuint height, GLuint fps)
+{
+  out << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C444\n";
+}
+
+/**
+ * Converts an RGBA8 image to planar YUV 4:4:4 and writes it as one Y4M frame.
+ */
+void writeY4MFrame(std::ostream& out, GLuint width, GLuint height, const unsigned char* rgba, bool bottomUp)
+{
+  out << "FRAME\n";
+
+  std::vector<unsigned char> row(width);
+  for (int plane{0}; plane < 3; ++plane)
+  {
+    for (GLuint y{0}; y < height; ++y)
+    {
+      const unsigned char* src{rgba + static_cast<size_t>(bottomUp ? height - 1 - y : y) * width * 4};
+      for (GLuint x{0}; x < width; ++x)
+      {
+        const int r{src[x * 4 + 0]}, g{src[x * 4 + 1]}, b{src[x * 4 + 2]};
+        switch (plane)
+        {
+          case 0:
+            row[x] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            break;  // Y
+          case 1:
+            row[x] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            break;  // U
+          default:
+            row[x] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            break;  // V
+        }
+      }
+      out.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+  }
+}
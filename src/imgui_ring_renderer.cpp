@@ -0,0 +1,240 @@
+#include "../include/imgui_ring_renderer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "../include/imgui/imgui_impl_opengl3.h"
+
+static constexpr GLbitfield MapFlags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+
+/**
+ * Builds the first ring; needs a current GL 4.4 context, see isSupported().
+ * @param state The cache of the context, shared with the rest of the renderer.
+ * @param shader The program built from the imgui shaders, see GLResources::getImGuiShader().
+ */
+ImGuiRingRenderer::ImGuiRingRenderer(GLStateCache& state, Shader& shader) : state(state), shader(shader)
+{
+  projectionLocation = glGetUniformLocation(shader.ID, "projection");
+  glGenVertexArrays(1, &VAO);
+  createBuffer(InitialFrameBytes);
+}
+
+ImGuiRingRenderer::~ImGuiRingRenderer()
+{
+  if (!VAO) return;
+
+  destroyBuffer();
+  glDeleteVertexArrays(1, &VAO);
+  state.invalidate();
+}
+
+/**
+ * Forgets the GL objects without calling GL, for when their context has been destroyed and
+ * took them along; the destructor then has nothing left to delete.
+ */
+void ImGuiRingRenderer::abandon()
+{
+  VAO = buffer = 0;
+  mapped = nullptr;
+  fences.fill(nullptr);
+}
+
+/**
+ * Whether the current context can map a buffer persistently (glad is generated without extensions).
+ */
+bool ImGuiRingRenderer::isSupported() { return GLAD_GL_VERSION_4_4; }
+
+/**
+ * Allocates and maps a ring of RingFrames regions, and points the VAO at it for both vertices
+ * and indices.
+ * @param bytes Smallest size of one region.
+ */
+void ImGuiRingRenderer::createBuffer(GLsizeiptr bytes)
+{
+  // Regions start on a vertex, so a region's first vertex is a whole base vertex away from 0
+  frameBytes = (bytes + sizeof(ImDrawVert) - 1) / sizeof(ImDrawVert) * sizeof(ImDrawVert);
+
+  glGenBuffers(1, &buffer);
+  state.bindVertexArray(VAO);
+  state.bindBuffer(GL_ARRAY_BUFFER, buffer);
+  glBufferStorage(GL_ARRAY_BUFFER, frameBytes * RingFrames, nullptr, MapFlags);
+  mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, frameBytes * RingFrames, MapFlags));
+
+  // The index binding is part of the VAO
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+  glEnableVertexAttribArray(0);
+  glEnableVertexAttribArray(1);
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, pos));
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, uv));
+  glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)offsetof(ImDrawVert, col));
+
+  region = 0;
+}
+
+/**
+ * Waits for the GPU to be done with every region, then frees the ring.
+ */
+void ImGuiRingRenderer::destroyBuffer()
+{
+  for (GLuint i{0}; i < RingFrames; ++i) waitRegion(i);
+
+  state.bindBuffer(GL_ARRAY_BUFFER, buffer);
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+  glDeleteBuffers(1, &buffer);
+  buffer = 0;
+  mapped = nullptr;
+
+  // Deleting unbinds it, and its name can come back from glGenBuffers
+  state.invalidate();
+}
+
+/**
+ * Blocks until the draws that last read a region have finished.
+ */
+void ImGuiRingRenderer::waitRegion(GLuint index)
+{
+  if (!fences[index]) return;
+
+  while (glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+  {
+  }
+  glDeleteSync(fences[index]);
+  fences[index] = nullptr;
+}
+
+/**
+ * Binds what ImGui draws with. The projection is a uniform of the program, so it is only set
+ * again when the display rectangle changes, or another window's ring has set its own.
+ */
+void ImGuiRingRenderer::setupState(ImDrawData* drawData)
+{
+  shader.use(state);
+  state.bindVertexArray(VAO);
+  state.setBlend(true);
+  state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  state.activeTexture(GL_TEXTURE0);
+  glEnable(GL_SCISSOR_TEST);
+
+  const float left{drawData->DisplayPos.x}, right{left + drawData->DisplaySize.x};
+  const float top{drawData->DisplayPos.y}, bottom{top + drawData->DisplaySize.y};
+  const ImVec4 rectangle{left, top, right, bottom};
+  if (shader.claimUniforms(this) || rectangle.x != projected.x || rectangle.y != projected.y ||
+      rectangle.z != projected.z || rectangle.w != projected.w)
+  {
+    projected = rectangle;
+    const float projection[4][4]{
+        {2.0f / (right - left), 0.0f, 0.0f, 0.0f},
+        {0.0f, 2.0f / (top - bottom), 0.0f, 0.0f},
+        {0.0f, 0.0f, -1.0f, 0.0f},
+        {(right + left) / (left - right), (top + bottom) / (bottom - top), 0.0f, 1.0f},
+    };
+    glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, &projection[0][0]);
+  }
+}
+
+/**
+ * Hands the textures ImGui wants created, updated or destroyed to the stock backend. It puts
+ * the texture binding back as it found it, but a destroyed texture's name can be reused.
+ */
+void ImGuiRingRenderer::updateTextures(ImDrawData* drawData)
+{
+  if (!drawData->Textures) return;
+
+  bool destroyed{false};
+  for (ImTextureData* texture : *drawData->Textures)
+  {
+    if (texture->Status == ImTextureStatus_OK) continue;
+    destroyed |= texture->Status == ImTextureStatus_WantDestroy;
+    ImGui_ImplOpenGL3_UpdateTexture(texture);
+  }
+  if (destroyed) state.invalidate();
+}
+
+/**
+ * Draws a frame of ImGui: copies every draw list into the next region of the ring, then issues
+ * one draw per command, fenced so the region is not overwritten while in flight.
+ * @param drawData From ImGui::GetDrawData() after ImGui::Render().
+ */
+void ImGuiRingRenderer::render(ImDrawData* drawData)
+{
+  const ImVec2 clipOffset{drawData->DisplayPos};
+  const ImVec2 clipScale{drawData->FramebufferScale};
+  const float framebufferHeight{drawData->DisplaySize.y * clipScale.y};
+  if (drawData->DisplaySize.x * clipScale.x <= 0.0f || framebufferHeight <= 0.0f) return;
+
+  updateTextures(drawData);
+  if (drawData->TotalVtxCount == 0) return;
+
+  const GLsizeiptr vertexBytes{static_cast<GLsizeiptr>(drawData->TotalVtxCount * sizeof(ImDrawVert))};
+  const GLsizeiptr neededBytes{vertexBytes + static_cast<GLsizeiptr>(drawData->TotalIdxCount * sizeof(ImDrawIdx))};
+  if (neededBytes > frameBytes)
+  {
+    const GLsizeiptr grown{std::max(neededBytes, frameBytes * 2)};
+    destroyBuffer();
+    createBuffer(grown);
+  }
+  waitRegion(region);
+
+  // Vertices of every list, then their indices; both stay aligned since a region starts on a vertex
+  const GLsizeiptr start{static_cast<GLsizeiptr>(region) * frameBytes};
+  char* vertices{mapped + start};
+  char* indices{vertices + vertexBytes};
+  for (const ImDrawList* list : drawData->CmdLists)
+  {
+    const size_t listVertexBytes{list->VtxBuffer.Size * sizeof(ImDrawVert)};
+    const size_t listIndexBytes{list->IdxBuffer.Size * sizeof(ImDrawIdx)};
+    std::memcpy(vertices, list->VtxBuffer.Data, listVertexBytes);
+    std::memcpy(indices, list->IdxBuffer.Data, listIndexBytes);
+    vertices += listVertexBytes;
+    indices += listIndexBytes;
+  }
+
+  setupState(drawData);
+
+  constexpr GLenum IndexType{sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT};
+  GLint baseVertex{static_cast<GLint>(start / sizeof(ImDrawVert))};
+  GLsizeiptr indexOffset{start + vertexBytes};
+  for (const ImDrawList* list : drawData->CmdLists)
+  {
+    for (const ImDrawCmd& command : list->CmdBuffer)
+    {
+      if (command.UserCallback)
+      {
+        if (command.UserCallback == ImDrawCallback_ResetRenderState)
+        {
+          setupState(drawData);
+        }
+        else
+        {
+          command.UserCallback(list, &command);
+        }
+        continue;
+      }
+
+      // Clip rectangle in framebuffer pixels, GL's scissor counts rows from the bottom
+      const ImVec2 clipMin{(command.ClipRect.x - clipOffset.x) * clipScale.x,
+                           (command.ClipRect.y - clipOffset.y) * clipScale.y};
+      const ImVec2 clipMax{(command.ClipRect.z - clipOffset.x) * clipScale.x,
+                           (command.ClipRect.w - clipOffset.y) * clipScale.y};
+      if (clipMax.x <= clipMin.x || clipMax.y <= clipMin.y) continue;
+      glScissor(static_cast<GLint>(clipMin.x), static_cast<GLint>(framebufferHeight - clipMax.y),
+                static_cast<GLsizei>(clipMax.x - clipMin.x), static_cast<GLsizei>(clipMax.y - clipMin.y));
+
+      state.bindTexture(GL_TEXTURE_2D, static_cast<GLuint>(static_cast<intptr_t>(command.GetTexID())));
+      glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.ElemCount), IndexType,
+                               reinterpret_cast<const void*>(indexOffset + command.IdxOffset * sizeof(ImDrawIdx)),
+                               baseVertex + static_cast<GLint>(command.VtxOffset));
+    }
+    baseVertex += list->VtxBuffer.Size;
+    indexOffset += list->IdxBuffer.Size * sizeof(ImDrawIdx);
+  }
+
+  // The rest of the frame draws unclipped
+  glDisable(GL_SCISSOR_TEST);
+
+  fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  region = (region + 1) % RingFrames;
+}
@@ -0,0 +1,82 @@
+#include "../include/latency_tracker.hpp"
+
+/**
+ * Marks the frame just presented as the first to show an input. Call right after display().
+ * @param inputTime When the key event came in.
+ * @param appliedTime When the simulation tick that applied it ran.
+ */
+void LatencyTracker::frameShown(TimePoint inputTime, TimePoint appliedTime)
+{
+  // The GPU is far behind; skip this input rather than pile up queries
+  if (pending.size() >= MaxPending) return;
+
+  GLuint query{0};
+  if (freeQueries.empty())
+  {
+    glGenQueries(1, &query);
+  }
+  else
+  {
+    query = freeQueries.back();
+    freeQueries.pop_back();
+  }
+
+  // The query records when the GPU is done with everything before it. Reading the GPU clock now
+  // as well pins GPU time to CPU time, to convert the result with.
+  glQueryCounter(query, GL_TIMESTAMP);
+  GLint64 gpuNow{0};
+  glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+
+  pending.push_back({query, inputTime, appliedTime, std::chrono::steady_clock::now(), gpuNow});
+}
+
+/**
+ * Turns the queries the GPU has finished into samples. Call once per frame; never blocks.
+ */
+void LatencyTracker::collect()
+{
+  size_t done{0};
+  for (; done < pending.size(); ++done)
+  {
+    const Pending& frame{pending[done]};
+
+    // Queries finish in order, so the first unfinished one ends the scan
+    GLint available{0};
+    glGetQueryObjectiv(frame.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) break;
+
+    GLuint64 gpuDone{0};
+    glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &gpuDone);
+    const auto shownTime{frame.cpuReference +
+                         std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(
+                             static_cast<GLint64>(gpuDone) - frame.gpuReference))};
+
+    applied.record(frame.appliedTime - frame.inputTime);
+    shown.record(shownTime - frame.inputTime);
+    freeQueries.push_back(frame.query);
+  }
+
+  pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(done));
+  if (done > 0) shownSummary = shown.summarize();
+}
+
+/**
+ * Deletes the GL queries. Needs the context to still be current.
+ */
+void LatencyTracker::destroy()
+{
+  for (const Pending& frame : pending) freeQueries.push_back(frame.query);
+  pending.clear();
+
+  if (!freeQueries.empty()) glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+  freeQueries.clear();
+}
+
+/**
+ * Writes the latency distribution of both stages as a small table.
+ * @param out Where to write it.
+ */
+void LatencyTracker::report(std::ostream& out) const
+{
+  TimingHistogram::report(out, "Input latency", {{"key to tick", &applied}, {"key to photon", &shown}});
+}
@@ -0,0 +1,309 @@
+#include "../include/leaderboard.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+
+#include "../include/checksum.hpp"
+
+static_assert(sizeof(Leaderboard::Record) == 32, "records are 32 bytes on disk");
+
+namespace
+{
+// File header, followed by the records
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+};
+
+constexpr FileHeader CurrentHeader{{'S', 'N', 'A', 'K', 'E', 'L', 'B', '\0'}, 1, sizeof(Leaderboard::Record)};
+}  // namespace
+
+Leaderboard::~Leaderboard() { close(); }
+
+/**
+ * Where the leaderboard lives by default: $SNAKE_LEADERBOARD, else under $XDG_DATA_HOME
+ * or ~/.local/share. Empty when there is nowhere to put it.
+ */
+std::string Leaderboard::defaultPath()
+{
+  if (const char* file = std::getenv("SNAKE_LEADERBOARD")) return file;
+  if (const char* dir = std::getenv("XDG_DATA_HOME"); dir && *dir)
+  {
+    return std::string(dir) + "/snake-game-2d/leaderboard.bin";
+  }
+  if (const char* home = std::getenv("HOME"); home && *home)
+  {
+    return std::string(home) + "/.local/share/snake-game-2d/leaderboard.bin";
+  }
+  return "";
+}
+
+/**
+ * Checksum a record is stored with: CRC-32 of every field before it.
+ * @param record The record.
+ */
+uint32_t Leaderboard::checksum(const Record& record)
+{
+  return crc32(&record, offsetof(Record, checksum));
+}
+
+/**
+ * Opens the leaderboard file, creating it if needed, and starts loading it in the background.
+ * @param file Path of the file; its directory is created too.
+ * @return Whether runs can be added. A file that isn't a leaderboard is left alone.
+ */
+bool Leaderboard::open(const std::string& file)
+{
+  close();
+  path = file;
+  topCount = runCount = dropped = unsynced = 0;
+  best = 0;
+  loaded = false;
+  closing = false;
+
+  std::error_code error;
+  const std::filesystem::path parent{std::filesystem::path(path).parent_path()};
+  if (!parent.empty()) std::filesystem::create_directories(parent, error);
+
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Leaderboard: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  struct stat info{};
+  fstat(fd, &info);
+
+  // Only a new, empty file gets a header; anything else must already be a leaderboard
+  if (info.st_size == 0)
+  {
+    if (write(fd, &CurrentHeader, sizeof(CurrentHeader)) != sizeof(CurrentHeader) || fsync(fd) != 0)
+    {
+      std::cerr << "Leaderboard: cannot write " << path << ": " << std::strerror(errno) << std::endl;
+      close();
+      return false;
+    }
+  }
+  else
+  {
+    FileHeader header{};
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        std::memcmp(&header, &CurrentHeader, sizeof(header)) != 0)
+    {
+      std::cerr << "Leaderboard: " << path << " is not a leaderboard file, not touching it" << std::endl;
+      ::close(fd);
+      fd = -1;
+      return false;
+    }
+  }
+
+  // A partial record at the end, left by a crash in the middle of an append, is cut off
+  // before anything else is appended, so new records line up again
+  fstat(fd, &info);
+  const size_t records{(static_cast<size_t>(info.st_size) - sizeof(FileHeader)) / sizeof(Record)};
+  const size_t validSize{sizeof(FileHeader) + records * sizeof(Record)};
+  if (static_cast<size_t>(info.st_size) > validSize && ftruncate(fd, static_cast<off_t>(validSize)) != 0)
+  {
+    std::cerr << "Leaderboard: cannot repair " << path << ": " << std::strerror(errno) << std::endl;
+  }
+
+  // Runs added from here on are counted as they come, the loader only scans what is there now
+  loader = std::thread(&Leaderboard::run, this, records);
+  return true;
+}
+
+/**
+ * Loader thread: loads the file, then stays around until close() to sync appended runs, once
+ * SyncBatch of them are waiting or the oldest is SyncInterval old. The sync itself runs without
+ * the mutex, so adding runs never waits for the disk.
+ * @param records How many records the file held when it was opened.
+ */
+void Leaderboard::run(size_t records)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  load(records);
+
+  while (!closing)
+  {
+    const auto due{firstUnsynced + SyncInterval};
+    if (unsynced >= SyncBatch || (unsynced > 0 && std::chrono::steady_clock::now() >= due))
+    {
+      const int file{fd};
+      unsynced = 0;
+      lock.unlock();
+      fdatasync(file);
+      lock.lock();
+    }
+    else if (unsynced == 0)
+    {
+      wake.wait(lock);
+    }
+    else
+    {
+      wake.wait_until(lock, due);
+    }
+  }
+}
+
+/**
+ * Maps the file, checks every record and keeps the best ones. Damaged records are skipped.
+ * Called with the mutex held.
+ * @param records How many records the file held when it was opened.
+ */
+void Leaderboard::load(size_t records)
+{
+  const size_t validSize{sizeof(FileHeader) + records * sizeof(Record)};
+
+  if (records > 0)
+  {
+    void* mapped{mmap(nullptr, validSize, PROT_READ, MAP_PRIVATE, fd, 0)};
+    if (mapped == MAP_FAILED)
+    {
+      std::cerr << "Leaderboard: cannot map " << path << ": " << std::strerror(errno) << std::endl;
+    }
+    else
+    {
+      madvise(mapped, validSize, MADV_SEQUENTIAL);
+      const auto* data{static_cast<const unsigned char*>(mapped) + sizeof(FileHeader)};
+
+      for (size_t i{0}; i < records; ++i)
+      {
+        Record record;
+        std::memcpy(&record, data + i * sizeof(Record), sizeof(Record));
+        if (record.checksum != checksum(record))
+        {
+          ++dropped;
+          continue;
+        }
+        ++runCount;
+        insert(record);
+      }
+      munmap(mapped, validSize);
+    }
+  }
+
+  if (dropped > 0) std::cerr << "Leaderboard: skipped " << dropped << " damaged runs in " << path << std::endl;
+
+  loaded.store(true, std::memory_order_release);
+}
+
+/**
+ * Puts a run into the in-memory top list if it makes it. Ties keep the earlier run ahead.
+ */
+void Leaderboard::insert(const Record& record)
+{
+  if (topCount == TopCount && record.score <= top[TopCount - 1].score) return;
+
+  size_t rank{0};
+  while (rank < topCount && top[rank].score >= record.score) ++rank;
+
+  if (topCount < TopCount) ++topCount;
+  std::copy_backward(top.begin() + rank, top.begin() + topCount - 1, top.begin() + topCount);
+  top[rank] = record;
+
+  best.store(top[0].score, std::memory_order_relaxed);
+}
+
+/**
+ * Appends a finished run. Waits for the loader if it is still scanning.
+ * @param score Final score.
+ * @param length Final snake length.
+ * @param ticks How many ticks the run lasted.
+ * @param source Who played it.
+ */
+void Leaderboard::add(uint32_t score, uint32_t length, uint32_t ticks, Source source)
+{
+  if (fd < 0) return;
+
+  Record record{static_cast<uint64_t>(std::time(nullptr)), score, length, ticks, source, 0, 0};
+  record.checksum = checksum(record);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // One write per record: O_APPEND puts it at the end even with other writers
+  if (write(fd, &record, sizeof(record)) != sizeof(record))
+  {
+    std::cerr << "Leaderboard: cannot append to " << path << ": " << std::strerror(errno) << std::endl;
+    return;
+  }
+  ++runCount;
+  insert(record);
+
+  // The loader thread syncs; it only needs waking for a first run to time, or a full batch
+  if (unsynced++ == 0) firstUnsynced = std::chrono::steady_clock::now();
+  if (unsynced == 1 || unsynced == SyncBatch) wake.notify_one();
+}
+
+/**
+ * Flushes appended runs to disk.
+ */
+void Leaderboard::sync()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if (fd < 0 || unsynced == 0) return;
+
+  const int file{fd};
+  unsynced = 0;
+  lock.unlock();
+  fdatasync(file);
+}
+
+/**
+ * Finishes loading, flushes and closes the file. Lookups keep their values.
+ */
+void Leaderboard::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closing = true;
+  }
+  wake.notify_one();
+  if (loader.joinable()) loader.join();
+  if (fd < 0) return;
+
+  sync();
+  ::close(fd);
+  fd = -1;
+}
+
+/**
+ * Runs stored, damaged ones not counted.
+ */
+size_t Leaderboard::getRunCount() const
+{
+  if (!isLoaded()) return 0;
+  std::lock_guard<std::mutex> lock(mutex);
+  return runCount;
+}
+
+/**
+ * Runs in the top list, up to TopCount.
+ */
+size_t Leaderboard::getTopCount() const
+{
+  if (!isLoaded()) return 0;
+  std::lock_guard<std::mutex> lock(mutex);
+  return topCount;
+}
+
+/**
+ * One run of the top list.
+ * @param rank 0 for the best run, below getTopCount().
+ */
+Leaderboard::Record Leaderboard::getTop(size_t rank) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return top[rank];
+}
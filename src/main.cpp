@@ -1,14 +1,83 @@
 #include <SFML/Window.hpp>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <vector>
 
 #include "../include/game.hpp"
 #include "../include/glad/glad.h"
+#include "../include/options.hpp"
+#include "../include/spectator.hpp"
+#include "../include/surface.hpp"
+#include "../include/trace.hpp"
 
-int main()
+int main(int argc, char* argv[])
 {
-  Game game;
+  const LaunchOptions options{LaunchOptions::parse(argc, argv)};
+  Surface::catchInterrupts();
 
-  // run the game loop
-  game.run();
+  if (!options.tracePath.empty())
+  {
+    Trace::nameThread("main");
+    Trace::start();
+  }
+
+  try
+  {
+    if (options.spectateGames)
+    {
+      Spectator spectator(options);
+      spectator.run();
+    }
+    else if (options.instances > 1)
+    {
+      // Later games share the first one's GL objects; all are driven from this thread in turn
+      std::vector<std::unique_ptr<Game>> games;
+      for (GLuint i{0}; i < options.instances; ++i)
+      {
+        games.push_back(std::make_unique<Game>(options.forInstance(i), games.empty() ? nullptr : games.front().get()));
+      }
+
+      for (auto& game : games) game->start();
+      for (bool anyRunning{true}; anyRunning;)
+      {
+        anyRunning = false;
+        for (auto& game : games)
+        {
+          if (!game->isRunning()) continue;
+          game->activate();
+          game->frame(Game::SharedIdleTimeout);
+          anyRunning = true;
+        }
+      }
+      for (auto& game : games)
+      {
+        game->activate();
+        game->finish();
+      }
+
+      // The first game goes last, its context is the one the shared objects were made in
+      while (!games.empty()) games.pop_back();
+    }
+    else
+    {
+      Game game(options);
+
+      // run the game loop
+      game.run();
+    }
+
+    // Every other thread has been joined by now
+    if (!options.tracePath.empty() && !Trace::write(options.tracePath))
+    {
+      std::cerr << "Failed to write " << options.tracePath << std::endl;
+    }
+  }
+  catch (const std::exception& error)
+  {
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
 
   return 0;
 }
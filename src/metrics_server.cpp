@@ -0,0 +1,208 @@
+#include "../include/metrics_server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+/**
+ * HELP and TYPE lines of a metric, unless its previous sample already wrote them.
+ */
+void MetricsWriter::header(const char* name, const char* help, const char* type)
+{
+  if (lastName && std::strcmp(lastName, name) == 0) return;
+  lastName = name;
+
+  text += "# HELP ";
+  text += name;
+  text += ' ';
+  text += help;
+  text += "\n# TYPE ";
+  text += name;
+  text += ' ';
+  text += type;
+  text += '\n';
+}
+
+/**
+ * One sample line: name, suffix, labels and value.
+ */
+void MetricsWriter::sample(const char* name, const char* suffix, const std::string& labels, double value)
+{
+  text += name;
+  text += suffix;
+  if (!labels.empty())
+  {
+    text += '{';
+    text += labels;
+    text += '}';
+  }
+
+  char number[32];
+  std::snprintf(number, sizeof(number), " %.15g\n", value);
+  text += number;
+}
+
+/**
+ * A value that only goes up, e.g. ticks run; rates come from the scraper.
+ */
+void MetricsWriter::counter(const char* name, const char* help, double value, const std::string& labels)
+{
+  header(name, help, "counter");
+  sample(name, "", labels, value);
+}
+
+/**
+ * A value that goes up and down, e.g. a queue depth.
+ */
+void MetricsWriter::gauge(const char* name, const char* help, double value, const std::string& labels)
+{
+  header(name, help, "gauge");
+  sample(name, "", labels, value);
+}
+
+/**
+ * A histogram's p50, p99 and p99.9, sum and count, in seconds.
+ */
+void MetricsWriter::summary(const char* name, const char* help, const TimingHistogram& histogram,
+                            const std::string& labels)
+{
+  header(name, help, "summary");
+
+  const TimingHistogram::Summary summary{histogram.summarize()};
+  const std::string prefix{labels.empty() ? "" : labels + ","};
+  const std::pair<const char*, double> quantiles[]{{"0.5", summary.p50}, {"0.99", summary.p99}, {"0.999", summary.p999}};
+  for (const auto& [quantile, ms] : quantiles)
+  {
+    sample(name, "", prefix + "quantile=\"" + quantile + "\"", ms / 1000.0);
+  }
+  sample(name, "_sum", labels, summary.mean * summary.count / 1000.0);
+  sample(name, "_count", labels, static_cast<double>(summary.count));
+}
+
+/**
+ * Heap allocations counted in some scopes, as snake_allocations_total, snake_allocated_bytes_total
+ * and snake_allocation_peak labelled by scope. Only meaningful with SNAKE_ALLOC_TRACKING.
+ * @param scopes Name and counter of each scope.
+ */
+void MetricsWriter::allocations(std::initializer_list<std::pair<const char*, const AllocCounter*>> scopes)
+{
+  for (const auto& [scope, allocated] : scopes)
+  {
+    counter("snake_allocations_total", "Heap allocations made in the scope.",
+            static_cast<double>(allocated->allocations.load(std::memory_order_relaxed)),
+            std::string("scope=\"") + scope + "\"");
+  }
+  for (const auto& [scope, allocated] : scopes)
+  {
+    counter("snake_allocated_bytes_total", "Bytes allocated in the scope.",
+            static_cast<double>(allocated->bytes.load(std::memory_order_relaxed)), std::string("scope=\"") + scope + "\"");
+  }
+  for (const auto& [scope, allocated] : scopes)
+  {
+    gauge("snake_allocation_peak", "Most allocations made in one run of the scope.",
+          static_cast<double>(allocated->peak.load(std::memory_order_relaxed)), std::string("scope=\"") + scope + "\"");
+  }
+}
+
+/**
+ * Starts listening on 127.0.0.1; only reports failure, the game runs on without metrics.
+ * @param port TCP port.
+ * @param collector Writes the metrics of a scrape, on the server thread.
+ */
+MetricsServer::MetricsServer(uint16_t port, Collector collector) : collector(std::move(collector))
+{
+  listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listener < 0)
+  {
+    std::cerr << "Metrics: cannot create a socket: " << std::strerror(errno) << std::endl;
+    return;
+  }
+
+  const int reuse{1};
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  // Loopback only: the endpoint has no authentication
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0)
+  {
+    std::cerr << "Metrics: cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << std::endl;
+    ::close(listener);
+    listener = -1;
+    return;
+  }
+
+  std::cout << "Metrics on http://127.0.0.1:" << port << "/metrics" << std::endl;
+  thread = std::thread(&MetricsServer::loop, this);
+}
+
+MetricsServer::~MetricsServer()
+{
+  stopping = true;
+  if (thread.joinable()) thread.join();
+  if (listener >= 0) ::close(listener);
+}
+
+/**
+ * Server thread: answers one connection at a time, checking for shutdown every PollMs.
+ */
+void MetricsServer::loop()
+{
+  while (!stopping)
+  {
+    pollfd waiting{listener, POLLIN, 0};
+    if (poll(&waiting, 1, PollMs) <= 0) continue;
+
+    const int client{accept4(listener, nullptr, nullptr, SOCK_CLOEXEC)};
+    if (client < 0) continue;
+
+    // A client that never sends its request can't hold the thread for long
+    const timeval timeout{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    serve(client);
+    ::close(client);
+  }
+}
+
+/**
+ * Answers one HTTP request: the metrics for GET /metrics, 404 for anything else.
+ */
+void MetricsServer::serve(int client)
+{
+  // The request line is all that matters, and it is in the first packet
+  char request[1024];
+  const ssize_t received{recv(client, request, sizeof(request) - 1, 0)};
+  if (received <= 0) return;
+  request[received] = '\0';
+
+  std::string status{"404 Not Found"}, body{"Not found, try /metrics\n"};
+  if (std::strncmp(request, "GET /metrics ", 13) == 0 || std::strncmp(request, "GET /metrics?", 13) == 0)
+  {
+    MetricsWriter writer;
+    writer.gauge("snake_uptime_seconds", "Seconds since the metrics server started.",
+                 std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+    collector(writer);
+    status = "200 OK";
+    body = writer.getText();
+  }
+
+  const std::string response{"HTTP/1.1 " + status +
+                             "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: " +
+                             std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body};
+  size_t sent{0};
+  while (sent < response.size())
+  {
+    const ssize_t written{send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL)};
+    if (written <= 0) return;
+    sent += static_cast<size_t>(written);
+  }
+}
@@ -0,0 +1,254 @@
+#include "../include/options.hpp"
+
+#include "../include/terminal_renderer.hpp"
+
+#include <SFML/Window/VideoMode.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+static void printUsage(const char* program)
+{
+  std::cout << "Usage: " << program << " [options]\n"
+            << "  --headless         Render offscreen through EGL, without a display server\n"
+            << "  --software         Render on the CPU into memory, without OpenGL\n"
+            << "  --terminal         Draw in this terminal with 24-bit color, e.g. over SSH\n"
+            << "  --size WxH         Framebuffer size (default: half the desktop, 960x540 offscreen),\n"
+            << "                     in cells with --terminal (default: fill the terminal)\n"
+            << "  --frames N         Exit after N frames (default: 1 when offscreen, until stopped with --metrics-port)\n"
+            << "  --output FILE      Save the last frame as a PPM image (offscreen only)\n"
+            << "  --record FILE      Record every frame, as Y4M video for *.y4m, else as a PPM stream\n"
+            << "  --spectate N       Watch N bot games at once instead of playing\n"
+            << "  --input-buffer N   Turns to queue up ahead of the snake, 1 to 16 (default: 3)\n"
+            << "  --trace FILE       Write a Chrome trace JSON timeline of frames and ticks on exit\n"
+            << "  --leaderboard FILE Record every run in FILE (default when playing in a window:\n"
+            << "                     ~/.local/share/snake-game-2d/leaderboard.bin)\n"
+            << "  --telemetry FILE   Append seed, settings and outcome of every game to FILE, for snake_query\n"
+            << "  --metrics-port N   Serve Prometheus metrics on http://127.0.0.1:N/metrics\n"
+            << "  --gui-renderer R   Draw ImGui with the stock backend or a persistent ring buffer:\n"
+            << "                     stock or ring (default: ring where GL 4.4 allows)\n"
+            << "  --instances N      Play N games at once, 1 to 16, each in its own window or offscreen\n"
+            << "                     surface, sharing compiled programs and buffers (default: 1)\n"
+            << "  --help             Show this message\n";
+}
+
+/**
+ * Parses command line arguments.
+ * Exits with a usage message on unknown or malformed options.
+ * @param argc Argument count from main.
+ * @param argv Argument values from main.
+ * @return The parsed options.
+ */
+LaunchOptions LaunchOptions::parse(int argc, char* argv[])
+{
+  LaunchOptions options;
+
+  for (int i{1}; i < argc; ++i)
+  {
+    const std::string arg{argv[i]};
+    const bool hasValue{i + 1 < argc};
+
+    if (arg == "--headless")
+    {
+#ifndef SNAKE_HEADLESS
+      std::cerr << "This build has no headless backend, configure with -DSNAKE_HEADLESS=ON\n";
+      exit(1);
+#endif
+      options.backend = Backend::Headless;
+    }
+    else if (arg == "--software")
+    {
+      options.backend = Backend::Software;
+    }
+    else if (arg == "--terminal")
+    {
+      options.backend = Backend::Terminal;
+    }
+    else if (arg == "--size" && hasValue)
+    {
+      unsigned width{0}, height{0};
+      if (std::sscanf(argv[++i], "%ux%u", &width, &height) != 2 || width == 0 || height == 0)
+      {
+        std::cerr << "Invalid --size, expected WxH\n";
+        exit(1);
+      }
+      options.size = {width, height};
+    }
+    else if (arg == "--frames" && hasValue)
+    {
+      options.frames = static_cast<GLuint>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if (arg == "--output" && hasValue)
+    {
+      options.outputPath = argv[++i];
+    }
+    else if (arg == "--record" && hasValue)
+    {
+      options.recordPath = argv[++i];
+    }
+    else if (arg == "--spectate" && hasValue)
+    {
+      options.spectateGames = static_cast<GLuint>(std::strtoul(argv[++i], nullptr, 10));
+      if (options.spectateGames == 0)
+      {
+        std::cerr << "Invalid --spectate, expected a game count\n";
+        exit(1);
+      }
+    }
+    else if (arg == "--input-buffer" && hasValue)
+    {
+      options.inputDepth = static_cast<GLuint>(std::strtoul(argv[++i], nullptr, 10));
+      if (options.inputDepth == 0 || options.inputDepth > 16)
+      {
+        std::cerr << "Invalid --input-buffer, expected 1 to 16\n";
+        exit(1);
+      }
+    }
+    else if (arg == "--trace" && hasValue)
+    {
+#ifndef SNAKE_TRACE
+      std::cerr << "This build has no tracing, configure with -DSNAKE_TRACE=ON\n";
+      exit(1);
+#endif
+      options.tracePath = argv[++i];
+    }
+    else if (arg == "--leaderboard" && hasValue)
+    {
+      options.leaderboardPath = argv[++i];
+    }
+    else if (arg == "--telemetry" && hasValue)
+    {
+      options.telemetryPath = argv[++i];
+    }
+    else if (arg == "--metrics-port" && hasValue)
+    {
+      options.metricsPort = static_cast<GLuint>(std::strtoul(argv[++i], nullptr, 10));
+      if (options.metricsPort == 0 || options.metricsPort > 65535)
+      {
+        std::cerr << "Invalid --metrics-port, expected 1 to 65535\n";
+        exit(1);
+      }
+    }
+    else if (arg == "--gui-renderer" && hasValue)
+    {
+      const std::string renderer{argv[++i]};
+      if (renderer == "stock")
+      {
+        options.guiRenderer = GUIRenderer::Stock;
+      }
+      else if (renderer == "ring")
+      {
+        options.guiRenderer = GUIRenderer::Ring;
+      }
+      else
+      {
+        std::cerr << "Invalid --gui-renderer, expected stock or ring\n";
+        exit(1);
+      }
+    }
+    else if (arg == "--instances" && hasValue)
+    {
+      options.instances = static_cast<GLuint>(std::strtoul(argv[++i], nullptr, 10));
+      if (options.instances == 0 || options.instances > 16)
+      {
+        std::cerr << "Invalid --instances, expected 1 to 16\n";
+        exit(1);
+      }
+    }
+    else if (arg == "--help")
+    {
+      printUsage(argv[0]);
+      exit(0);
+    }
+    else
+    {
+      std::cerr << "Unknown option: " << arg << "\n";
+      printUsage(argv[0]);
+      exit(1);
+    }
+  }
+
+  // A window's back buffer is undefined once displayed, so only offscreen frames can be saved
+  if (!options.outputPath.empty() && (options.backend == Backend::Window || options.backend == Backend::Terminal))
+  {
+    std::cerr << "--output needs --headless or --software\n";
+    exit(1);
+  }
+
+  if (options.spectateGames && (options.backend == Backend::Software || options.backend == Backend::Terminal))
+  {
+    std::cerr << "--spectate needs a window or --headless\n";
+    exit(1);
+  }
+
+  // The terminal shows cells, there are no pixels to record
+  if (!options.recordPath.empty() && options.backend == Backend::Terminal)
+  {
+    std::cerr << "--record needs a window, --headless or --software\n";
+    exit(1);
+  }
+
+  // One terminal holds one board, and spectating already draws several games in one window
+  if (options.instances > 1 && (options.spectateGames || options.backend == Backend::Terminal))
+  {
+    std::cerr << "--instances needs a window, --headless or --software, without --spectate\n";
+    exit(1);
+  }
+
+  if (options.backend == Backend::Terminal)
+  {
+    if (options.size.first && (options.size.first < TerminalRenderer::MinColumns ||
+                               options.size.second < TerminalRenderer::MinRows))
+    {
+      std::cerr << "Invalid --size, a terminal board needs at least " << TerminalRenderer::MinColumns << "x"
+                << TerminalRenderer::MinRows << " cells\n";
+      exit(1);
+    }
+  }
+  else if (options.backend != Backend::Window)
+  {
+    if (options.size.first == 0) options.size = {960, 540};
+    // A metrics endpoint means a long soak run, going until SIGINT / SIGTERM
+    if (options.frames == 0 && !options.metricsPort) options.frames = 1;
+  }
+
+  return options;
+}
+
+/**
+ * Framebuffer size to start with: what was asked for, else half the desktop, or in a terminal
+ * as many cells as fit.
+ */
+ScreenSize LaunchOptions::getScreenSize() const
+{
+  if (size.first && size.second) return size;
+  if (backend == Backend::Terminal) return TerminalRenderer::getBoardSize(STDOUT_FILENO);
+
+  return {sf::VideoMode::getDesktopMode().size.x / 2, sf::VideoMode::getDesktopMode().size.y / 2};
+}
+
+/**
+ * Options for one of several games played at once: files written get the game's number before
+ * the extension ("run.ppm" becomes "run-2.ppm"), and only the first game serves metrics.
+ * @param index From 0; the first game keeps the options as given.
+ */
+LaunchOptions LaunchOptions::forInstance(GLuint index) const
+{
+  if (index == 0) return *this;
+
+  LaunchOptions options{*this};
+  const auto numbered{[index](const std::string& path)
+                      {
+                        if (path.empty()) return path;
+                        const size_t slash{path.find_last_of('/')};
+                        size_t dot{path.find_last_of('.')};
+                        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = path.size();
+                        return path.substr(0, dot) + "-" + std::to_string(index + 1) + path.substr(dot);
+                      }};
+  options.outputPath = numbered(outputPath);
+  options.recordPath = numbered(recordPath);
+  options.metricsPort = 0;
+  return options;
+}
@@ -6,78 +6,49 @@
 #include <vector>
 
 #include "../include/game.hpp"
+#include "../include/gl_profiler.hpp"
 #include "../include/glad/glad.h"
 #include "../include/glm/gtc/type_ptr.hpp"
-#include "../include/imgui/imgui_impl_sfml.h"
-
-RenderEngine::RenderEngine(sf::Window& window, Snake& snake, Shader& shaderProgram, Food& food, ScreenSize& screenSize,
-                           GridInfo& gridInfo, GUI& gui, Game* game)
-    : window(window),
-      shaderProgram(shaderProgram),
-      snake(snake),
-      food(food),
+#include "../include/trace.hpp"
+
+/**
+ * Sets up drawing to a surface whose context is current.
+ * @param resources Programs, quad and atlas, made in this context or one sharing with it.
+ */
+RenderEngine::RenderEngine(Surface& surface, GLResources& resources, ScreenSize& screenSize, GridInfo& gridInfo,
+                           GUI& gui, Game* game, GUIRenderer guiRenderer)
+    : surface(surface),
+      shaderProgram(resources.cellShader),
       game(game),
       screenSize(screenSize),
       gridInfo(gridInfo),
       gui(gui)
 {
-  setupQuad();
-  setupCoordinates();
+  mesh.create(&resources.quad);
 
-  // initialize ImGUI
-  gui.init(window);
+  // Items and a snake filling the grid, the most a snapshot can hold
+  renderQueue.reserve(2, gridInfo.getCellCount() + 5);
+
+  // initialize ImGUI before touching the game shader, so its own shaders compile while ours finish linking
+  gui.init(surface, glState, resources, guiRenderer);
   imguiInitialized = true;
+
+  setupCoordinates();
 }
 
 RenderEngine::~RenderEngine() { terminate(); }
 
-/**
- * Sets up a simple quad (square) for rendering.
- * The quad is defined with 4 vertices and 2 triangles.
- */
-void RenderEngine::setupQuad()
-{
-  // Define a simple 1x1 square with its bottom-left corner at the origin
-  std::vector<GLfloat> vertices{
-      0.5f,  0.5f,  0.0f,  // top right
-      0.5f,  -0.5f, 0.0f,  // bottom right
-      -0.5f, -0.5f, 0.0f,  // bottom left
-      -0.5f, 0.5f,  0.0f   // top left
-  };
-
-  std::vector<GLuint> indices{
-      0, 1, 3,  // first triangle
-      1, 2, 3   // second triangle
-  };
-
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  glGenBuffers(1, &EBO);
-
-  glBindVertexArray(VAO);
-
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-  // Vertex attribute (position only)
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
-  glEnableVertexAttribArray(0);
-
-  // Safety: unbind
-  glBindVertexArray(0);
-}
-
 /**
  * Sets up the view and projection matrices for 2D rendering.
  * The view matrix translates the scene back to view it properly.
  * The projection matrix is set to orthographic projection based on screen dimensions.
+ * Also sets the cell scale and the wraparound distance used for interpolation.
+ * They are uniforms of a program other windows draw with too, see Shader::claimUniforms().
  */
-void RenderEngine::setupCoordinates() const
+void RenderEngine::setupCoordinates()
 {
-  shaderProgram.use();
+  shaderProgram.use(glState);
+  shaderProgram.claimUniforms(this);
 
   glm::mat4 view{1.0f};
   auto [xMax, yMax]{gridInfo.getGridSizeF()};
@@ -87,6 +58,10 @@ void RenderEngine::setupCoordinates() const
 
   glUniformMatrix4fv(glGetUniformLocation(shaderProgram.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
   glUniformMatrix4fv(glGetUniformLocation(shaderProgram.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+  auto [wrapX, wrapY]{gridInfo.getWrapSize()};
+  shaderProgram.setFloat("scale", scaleFactor);
+  glUniform2f(glGetUniformLocation(shaderProgram.ID, "wrapSize"), wrapX, wrapY);
 }
 
 /**
@@ -105,42 +80,83 @@ void RenderEngine::clearScreen() const
 void RenderEngine::render()
 {
   // Poll SFML events once per frame
-  pollEvents();
+  {
+    TRACE_SCOPE("poll events");
+    pollEvents();
+    latency.collect();
+  }
 
   // === ImGui Frame Start ===
-  sf::Time dt{clock.restart()};
-  gui.beginFrame(window, dt);
+  {
+    TRACE_SCOPE("imgui build");
+    TimingScope timing(imguiBuildTimes);
+    sf::Time dt{clock.restart()};
+    gui.beginFrame(surface, dt);
+
+    // === Draw ImGui windows from Game ===
+    if (game)
+    {
+      game->showHUD();           // Always show HUD
+      game->showTimings();       // Debug panel, toggled with F3
+      game->showGameOverMenu();  // Shows when game is over
+      game->showPauseMenu();     // Shows only when paused
+    }
+
+    // Big food timer
+    if (snapshot && snapshot->bigFoodActive)
+    {
+      BigFood::drawUI(snapshot->bigFoodLife);
+    }
+  }
 
-  // === Draw ImGui windows from Game ===
-  if (game)
+  // === Clear and draw game ===
   {
-    game->showHUD();           // Always show HUD
-    game->showGameOverMenu();  // Shows when game is over
-    game->showPauseMenu();     // Shows only when paused
+    TRACE_SCOPE("draw cells");
+    clearScreen();
+    GL_CALLER(CallerCells);
+
+    // Draw the latest simulation state using OpenGL, the snake part way to its next cell
+    if (snapshot)
+    {
+      shaderProgram.use(glState);
+      if (shaderProgram.claimUniforms(this)) setupCoordinates();
+      shaderProgram.setFloat("alpha", snapshot->getMoveProgress(SimClock::now()));
+      snapshot->draw(renderQueue, mesh, shaderProgram);
+    }
+    renderQueue.flush(mesh.getInstanceVBO(), glState);
   }
 
-  // Big food timer
-  if (bigFood && bigFood->isActive)
+  // Draw ImGui on top of everything
   {
-    bigFood->drawUI();
+    TRACE_SCOPE("gui.endFrame");
+    GL_CALLER(CallerImGui);
+    gui.endFrame();
   }
 
-  // === Clear and draw game ===
-  clearScreen();
+  // Start reading the finished frame back while the back buffer is still defined
+  if (recorder)
+  {
+    TRACE_SCOPE("recorder capture");
+    GL_CALLER(CallerRecorder);
+    recorder->capture();
+  }
 
-  // Draw the snake and food using OpenGL
-  snake.draw(VAO);
-  food.draw(VAO);
-  if (bigFood && bigFood->isActive)
+  // Swap buffers / display frame
   {
-    bigFood->draw(VAO);
+    TRACE_SCOPE("display");
+    TimingScope timing(displayTimes);
+    surface.display();
   }
+  GLProfiler::endFrame();
 
-  // Draw ImGui on top of everything
-  gui.endFrame();
+  // First frame showing a new input: time when the GPU is done with it
+  if (snapshot && snapshot->inputTime != shownInput)
+  {
+    shownInput = snapshot->inputTime;
+    latency.frameShown(snapshot->inputTime, snapshot->inputAppliedTime);
+  }
 
-  // Swap buffers / display frame
-  window.display();
+  if (damagedFrames > 0) --damagedFrames;
 }
 
 /**
@@ -151,7 +167,7 @@ void RenderEngine::terminate()
   if (imguiInitialized)
   {
     // Ensure context is valid before ImGui shutdown
-    if (window.isOpen())
+    if (surface.hasContext())
     {
       gui.shutdown();
     }
@@ -159,11 +175,11 @@ void RenderEngine::terminate()
   }
 
   // Delete OpenGL resources safely only if context is active
-  if (window.isOpen())
+  if (surface.hasContext())
   {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    mesh.destroy();
+    latency.destroy();
+    glState.invalidate();
   }
 }
 
@@ -172,25 +188,55 @@ void RenderEngine::terminate()
  */
 void RenderEngine::pollEvents()
 {
-  while (const std::optional<sf::Event> event{window.pollEvent()})
+  while (const std::optional<sf::Event> event{surface.pollEvent()})
   {
-    // ImGUI events
-    ImGui::SFML::ProcessEvent(event.value());
+    handleEvent(event.value());
+  }
+}
 
-    if (event->is<sf::Event::Closed>())
-    {
-      window.close();
-    }
+/**
+ * Sleeps until an event arrives or the timeout runs out, then handles every pending event.
+ * Used instead of rendering while nothing on screen is changing.
+ * @param timeout Longest time to block.
+ */
+void RenderEngine::waitEvents(sf::Time timeout)
+{
+  if (const std::optional<sf::Event> event{surface.waitEvent(timeout)})
+  {
+    handleEvent(event.value());
+    pollEvents();
+  }
+}
 
-    if (event->is<sf::Event::Resized>())
-    {
-      // gridInfo.updateScreenSize()
-      glViewport(0, 0, window.getSize().x, window.getSize().y);
-    }
+/**
+ * Handles one window event; any event may change what is on screen.
+ * Listeners can read when it came in from getEventTime().
+ * @param event The event to handle.
+ */
+void RenderEngine::handleEvent(const sf::Event& event)
+{
+  eventTime = SimClock::now();
+  invalidate();
+
+  // ImGUI events
+  gui.processEvent(event);
+
+  if (event.is<sf::Event::Closed>())
+  {
+    // Closing the window takes the GL context with it, collect the frames still being read first
+    if (recorder) recorder->finish();
+    surface.close();
+  }
 
-    // dispatch other events to listeners
-    dispatchEvent(event.value());
+  if (event.is<sf::Event::Resized>())
+  {
+    // gridInfo.updateScreenSize()
+    auto [width, height]{surface.getSize()};
+    glViewport(0, 0, width, height);
   }
+
+  // dispatch other events to listeners
+  dispatchEvent(event);
 }
 
 /**
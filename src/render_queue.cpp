@@ -0,0 +1,105 @@
+#include "../include/render_queue.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+/**
+ * Orders keys by layer first, then by the state that is most expensive to switch.
+ */
+bool DrawKey::operator<(const DrawKey& other) const
+{
+  return std::make_tuple(layer, shader->ID, texture, VAO) <
+         std::make_tuple(other.layer, other.shader->ID, other.texture, other.VAO);
+}
+
+/**
+ * Whether two keys can share a draw. The layer only decides the order.
+ */
+bool DrawKey::sameState(const DrawKey& other) const
+{
+  return shader == other.shader && texture == other.texture && VAO == other.VAO;
+}
+
+/**
+ * Queues count instanced cell quads drawn with the given state.
+ * @param key The state to draw with.
+ * @param count Number of instances.
+ * @return Where to write the instances; valid until the next submit.
+ */
+CellInstance* RenderQueue::submit(const DrawKey& key, size_t count)
+{
+  packets.push_back({key, staging.size(), count});
+  staging.resize(staging.size() + count);
+  return staging.data() + staging.size() - count;
+}
+
+/**
+ * Makes room for a frame of the given size, so frames up to it never allocate.
+ * @param packetCount Submissions per frame.
+ * @param instanceCount Instances per frame.
+ */
+void RenderQueue::reserve(size_t packetCount, size_t instanceCount)
+{
+  packets.reserve(packetCount);
+  staging.reserve(instanceCount);
+  upload.reserve(instanceCount);
+}
+
+/**
+ * Draws everything submitted since the last flush, and empties the queue.
+ * Bindings go through the state cache, so state left bound by the last frame is not bound again.
+ * @param instanceVBO The per-instance buffer bound to the VAOs' instance attributes.
+ * @param state The cache of the context drawn to.
+ */
+void RenderQueue::flush(GLuint instanceVBO, GLStateCache& state)
+{
+  stats = {};
+  stats.packets = static_cast<GLuint>(packets.size());
+  stats.instances = static_cast<GLuint>(staging.size());
+
+  // Packets with equal keys keep their submission order, which is their order in staging.
+  // std::stable_sort would do the same but allocates a scratch buffer every frame.
+  std::sort(packets.begin(), packets.end(),
+            [](const Packet& a, const Packet& b)
+            { return a.key < b.key || (!(b.key < a.key) && a.first < b.first); });
+
+  // Lay the instances out in draw order, so each merged batch is one contiguous range
+  upload.clear();
+  for (const auto& packet : packets)
+  {
+    upload.insert(upload.end(), staging.begin() + packet.first, staging.begin() + packet.first + packet.count);
+  }
+
+  if (!upload.empty())
+  {
+    state.bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, upload.size() * sizeof(CellInstance), upload.data(), GL_STREAM_DRAW);
+  }
+
+  // Cells are opaque, transparent texels are discarded
+  state.setBlend(false);
+  state.activeTexture(GL_TEXTURE0);
+
+  size_t base{0};
+  for (size_t i{0}; i < packets.size();)
+  {
+    const DrawKey& key{packets[i].key};
+
+    // Merge the run of packets sharing this state
+    size_t count{0};
+    for (; i < packets.size() && packets[i].key.sameState(key); ++i) count += packets[i].count;
+    if (count == 0) continue;
+
+    stats.stateChanges += key.shader->use(state);
+    stats.stateChanges += state.bindVertexArray(key.VAO);
+    stats.stateChanges += state.bindTexture(GL_TEXTURE_2D, key.texture);
+
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count),
+                                        static_cast<GLuint>(base));
+    ++stats.draws;
+    base += count;
+  }
+
+  packets.clear();
+  staging.clear();
+}
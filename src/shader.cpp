@@ -1,37 +1,145 @@
 #include "../include/shader.hpp"
 #include "../include/glad/glad.h"
+#include "embedded_shaders.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
-Shader::Shader(const char *vertexPath, const char *fragmentPath) {
-  std::ifstream vsfile(vertexPath);
-  std::ifstream fsfile(fragmentPath);
-  if (!vsfile || !fsfile) {
-    throw std::runtime_error("Failed to open shader file");
+// KHR_parallel_shader_compile entry point (not in our glad profile)
+typedef void(APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+static std::string readFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Failed to open shader file: " + path);
   }
 
-  std::stringstream vsCodeStream, fsCodeStream;
-  vsCodeStream << vsfile.rdbuf();
-  fsCodeStream << fsfile.rdbuf();
+  std::stringstream codeStream;
+  codeStream << file.rdbuf();
+  return codeStream.str();
+}
 
-  GLint success;
-  GLuint vertexShader, fragmentShader;
+static bool hasExtension(const char *name) {
+  GLint count{0};
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; ++i) {
+    const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+    if (extension && std::strcmp(extension, name) == 0) return true;
+  }
+  return false;
+}
 
-  std::string vertexShaderCode = vsCodeStream.str();
-  const char *vertexShaderSource = vertexShaderCode.c_str();
+// FNV-1a, good enough to tell shader/driver combinations apart
+static uint64_t hashString(uint64_t hash, const char *data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash ^ 0xff;  // separator so "ab"+"c" != "a"+"bc"
+}
 
-  std::string fragmentShaderCode = fsCodeStream.str();
-  const char *fragmentShaderSource = fragmentShaderCode.c_str();
+/**
+ * Returns the game's shader sources.
+ * The sources are embedded into the binary at build time, so the game runs from any
+ * working directory. Set SNAKE_SHADER_DIR to a directory holding vertex.glsl and
+ * fragment.glsl to iterate on shaders without rebuilding.
+ */
+ShaderSource ShaderSource::load() {
+  const char *overrideDir = std::getenv("SNAKE_SHADER_DIR");
+  if (overrideDir && *overrideDir) {
+    std::string dir{overrideDir};
+    return {readFile(dir + "/vertex.glsl"), readFile(dir + "/fragment.glsl")};
+  }
+
+  return {EmbeddedShaders::vertex, EmbeddedShaders::fragment};
+}
+
+Shader::Shader(const char *vertexPath, const char *fragmentPath)
+    : Shader(ShaderSource{readFile(vertexPath), readFile(fragmentPath)}) {}
+
+/**
+ * Builds the program from source.
+ * With a cache directory, the linked program binary is stored there keyed by driver and
+ * source hash, and later launches load it back instead of compiling. Compilation itself
+ * is only issued here; status checks are deferred to the first use() so that drivers with
+ * parallel shader compilation can work in the background meanwhile.
+ * @param source The vertex and fragment shader sources.
+ * @param cacheDir Directory for program binaries, empty to disable caching.
+ */
+Shader::Shader(const ShaderSource &source, const std::string &cacheDir) {
+  Shader::ID = glCreateProgram();
+
+  GLint formats{0};
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (!cacheDir.empty() && formats > 0) {
+    const char *vendor = reinterpret_cast<const char *>(glGetString(GL_VENDOR));
+    const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+    const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+
+    uint64_t hash{14695981039346656037ull};
+    for (const char *part : {vendor, renderer, version}) {
+      if (part) hash = hashString(hash, part, std::strlen(part));
+    }
+    hash = hashString(hash, source.vertex.data(), source.vertex.size());
+    hash = hashString(hash, source.fragment.data(), source.fragment.size());
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+    cachePath = cacheDir + "/" + name;
+
+    if (loadBinary()) return;
+  }
+
+  compile(source);
+}
+
+/**
+ * Issues compilation of both stages and the program link without waiting for them.
+ * @param source The vertex and fragment shader sources.
+ */
+void Shader::compile(const ShaderSource &source) {
+  const char *vertexShaderSource = source.vertex.c_str();
+  const char *fragmentShaderSource = source.fragment.c_str();
 
-  char infoLog[512];
   // ################## Vertex Shader ##################
   vertexShader = glCreateShader(GL_VERTEX_SHADER);
   glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
   glCompileShader(vertexShader);
 
+  // ################## Fragment Shader ##################
+  fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+  glCompileShader(fragmentShader);
+
+  // ################## Shader Program ##################
+  glAttachShader(Shader::ID, vertexShader);
+  glAttachShader(Shader::ID, fragmentShader);
+
+  if (!cachePath.empty()) {
+    glProgramParameteri(Shader::ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+  glLinkProgram(Shader::ID);
+
+  pending = true;
+}
+
+/**
+ * Waits for a pending compile/link, reports errors and stores the binary in the cache.
+ */
+void Shader::finish() {
+  pending = false;
+
+  GLint success;
+  char infoLog[512];
+
   glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
   if (!success) {
     glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
@@ -39,11 +147,6 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath) {
               << infoLog << std::endl;
   }
 
-  // ################## Fragment Shader ##################
-  fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-  glCompileShader(fragmentShader);
-
   glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
   if (!success) {
     glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
@@ -51,12 +154,6 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath) {
               << infoLog << std::endl;
   }
 
-  // ################## Shader Program ##################
-  Shader::ID = glCreateProgram();
-  glAttachShader(Shader::ID, vertexShader);
-  glAttachShader(Shader::ID, fragmentShader);
-
-  glLinkProgram(Shader::ID);
   glGetProgramiv(Shader::ID, GL_LINK_STATUS, &success);
   if (!success) {
     glGetProgramInfoLog(Shader::ID, 512, NULL, infoLog);
@@ -64,11 +161,126 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath) {
               << infoLog << std::endl;
   }
 
+  glDetachShader(Shader::ID, vertexShader);
+  glDetachShader(Shader::ID, fragmentShader);
   glDeleteShader(vertexShader);
   glDeleteShader(fragmentShader);
+  vertexShader = fragmentShader = 0;
+
+  if (success && !cachePath.empty()) saveBinary();
 }
 
-void Shader::use() { glUseProgram(Shader::ID); }
+/**
+ * Loads the program from the binary cache.
+ * @return True if a cached binary was found and accepted by the driver.
+ */
+bool Shader::loadBinary() {
+  std::ifstream file(cachePath, std::ios::binary);
+  if (!file) return false;
+
+  GLenum format{0};
+  file.read(reinterpret_cast<char *>(&format), sizeof(format));
+  if (!file) return false;
+
+  std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  if (binary.empty()) return false;
+
+  glProgramBinary(Shader::ID, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+  // Drivers may reject binaries from an older build of themselves, compile from source then
+  GLint success;
+  glGetProgramiv(Shader::ID, GL_LINK_STATUS, &success);
+  return success;
+}
+
+/**
+ * Writes the linked program binary to the cache.
+ * The file is written next to its final name and renamed into place, so a crash never
+ * leaves a truncated binary behind.
+ */
+void Shader::saveBinary() const {
+  GLint length{0};
+  glGetProgramiv(Shader::ID, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+
+  std::vector<char> binary(length);
+  GLenum format{0};
+  glGetProgramBinary(Shader::ID, length, nullptr, &format, binary.data());
+
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+  const std::string tempPath{cachePath + ".tmp"};
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file) return;
+    file.write(reinterpret_cast<const char *>(&format), sizeof(format));
+    file.write(binary.data(), binary.size());
+    if (!file) return;
+  }
+  std::filesystem::rename(tempPath, cachePath, error);
+}
+
+/**
+ * Lets the driver compile shaders on its own threads, if it supports
+ * KHR_parallel_shader_compile (or the ARB variant).
+ * @param load Loader used to fetch the extension entry point.
+ * @return True if parallel compilation is available.
+ */
+bool Shader::enableParallelCompile(GLADloadproc load) {
+  const char *entryPoint{nullptr};
+  if (hasExtension("GL_KHR_parallel_shader_compile")) {
+    entryPoint = "glMaxShaderCompilerThreadsKHR";
+  } else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+    entryPoint = "glMaxShaderCompilerThreadsARB";
+  } else {
+    return false;
+  }
+
+  auto maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load(entryPoint));
+  if (maxShaderCompilerThreads) maxShaderCompilerThreads(0xFFFFFFFF);  // as many as the driver likes
+
+  return true;
+}
+
+/**
+ * Returns the directory used for program binaries:
+ * $SNAKE_SHADER_CACHE, else $XDG_CACHE_HOME/snake-game-2d, else ~/.cache/snake-game-2d.
+ * An empty SNAKE_SHADER_CACHE disables caching.
+ */
+std::string Shader::defaultCacheDir() {
+  if (const char *dir = std::getenv("SNAKE_SHADER_CACHE")) return dir;
+  if (const char *dir = std::getenv("XDG_CACHE_HOME"); dir && *dir) return std::string(dir) + "/snake-game-2d";
+  if (const char *home = std::getenv("HOME"); home && *home) return std::string(home) + "/.cache/snake-game-2d";
+  return "";
+}
+
+void Shader::use() {
+  if (pending) finish();
+  glUseProgram(Shader::ID);
+}
+
+/**
+ * Activates the shader through a state cache, skipping the bind when it is already in use.
+ * @return Whether it was bound.
+ */
+bool Shader::use(GLStateCache &state) {
+  if (pending) finish();
+  return state.useProgram(Shader::ID);
+}
+
+/**
+ * Records who is about to set the program's uniforms. Renderers sharing the program, from
+ * other windows' contexts or with other settings, each set their own uniforms again when
+ * someone else set them last.
+ * @param owner The renderer setting them, any pointer that identifies it.
+ * @return Whether someone else had set them, or no one has yet.
+ */
+bool Shader::claimUniforms(const void *owner) {
+  if (uniformOwner == owner) return false;
+  uniformOwner = owner;
+  return true;
+}
 
 void Shader::setBool(const std::string &name, bool value) const {
   glUniform1i(glGetUniformLocation(Shader::ID, name.c_str()), (int)value);
@@ -1,8 +1,18 @@
 #version 330 core
 
+in vec2 TexCoord;
+
 out vec4 FragColor;
 
+uniform sampler2D atlas;
+uniform vec4 color = vec4(1.0);  // tint
+
 void main()
 {
-  FragColor = vec4(1.0, 0.5, 0.2, 1.0);
+  vec4 texel = texture(atlas, TexCoord) * color;
+
+  // Sprites are cut out, no blending needed
+  if (texel.a < 0.5) discard;
+
+  FragColor = texel;
 }
@@ -0,0 +1,13 @@
+#version 330 core
+
+in vec2 UV;
+in vec4 Color;
+
+out vec4 FragColor;
+
+uniform sampler2D atlas;  // font atlas or a user texture, on unit 0
+
+void main()
+{
+  FragColor = Color * texture(atlas, UV);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// ImGui vertices: ImDrawVert
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aUV;
+layout (location = 2) in vec4 aColor;  // normalized from 8 bit RGBA
+
+out vec2 UV;
+out vec4 Color;
+
+uniform mat4 projection;  // display rectangle to clip space
+
+void main()
+{
+  UV = aUV;
+  Color = aColor;
+  gl_Position = projection * vec4(aPos, 0.0, 1.0);
+}
@@ -1,12 +1,35 @@
 #version 330 core
 
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aPreviousCell;  // cell on the previous simulation tick
+layout (location = 2) in vec2 aCell;          // cell on the current simulation tick
+layout (location = 3) in uvec2 aSprite;       // atlas sprite, clockwise quarter turns
+
+out vec2 TexCoord;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform float scale;     // quad size in cells
+uniform float alpha;     // progress from the previous tick to the current one, 0..1
+uniform vec2 wrapSize;   // how far a segment jumps when it wraps around an edge
+
+const uint AtlasColumns = 4u;  // SpriteAtlas::Columns
 
 void main()
 {
-  gl_Position = projection * view * model * vec4(aPos, 1.0);
+  // A jump of more than one cell is a wraparound: move the old position next to the new one
+  vec2 delta = aCell - aPreviousCell;
+  vec2 previous = aPreviousCell + step(1.5, abs(delta)) * sign(delta) * wrapSize;
+
+  vec2 cell = mix(previous, aCell, alpha);
+  vec3 position = vec3(cell - 0.5, 0.0) + aPos * scale;
+
+  gl_Position = projection * view * vec4(position, 1.0);
+
+  // Position across the quad, 0 at the top left (Y points down), turned clockwise
+  vec2 uv = aPos.xy + 0.5;
+  for (uint i = 0u; i < aSprite.y; ++i) uv = vec2(uv.y, 1.0 - uv.x);
+
+  vec2 origin = vec2(aSprite.x % AtlasColumns, aSprite.x / AtlasColumns);
+  TexCoord = (origin + uv) / float(AtlasColumns);
 }
@@ -0,0 +1,351 @@
+#include "../include/simulation.hpp"
+
+#include <algorithm>
+
+#include "../include/autopilot.hpp"
+#include "../include/trace.hpp"
+
+/**
+ * Converts seconds to the simulation clock's duration.
+ */
+static SimClock::duration toDuration(GLfloat seconds)
+{
+  return std::chrono::duration_cast<SimClock::duration>(std::chrono::duration<GLfloat>(seconds));
+}
+
+/**
+ * How far the snake is between its last move and the next one.
+ * @param now The time the frame is drawn for.
+ * @return 0 right after a move, up to 1 when the next move is due.
+ */
+GLfloat GameSnapshot::getMoveProgress(SimClock::time_point now) const
+{
+  if (paused) return pausedProgress;
+
+  const GLfloat progress{std::chrono::duration<GLfloat>(now - lastTick).count() / moveDelay};
+  return std::clamp(progress, 0.0f, 1.0f);
+}
+
+/**
+ * Queues the snapshot's cells for drawing: the items, and the snake on top of them.
+ * @param queue The frame's render queue.
+ * @param mesh The quad and sprite atlas to draw with.
+ * @param shader The cell program.
+ */
+void GameSnapshot::draw(RenderQueue& queue, const CellMesh& mesh, Shader& shader) const
+{
+  if (!items.empty())
+  {
+    std::copy(items.begin(), items.end(),
+              queue.submit({LayerItems, &shader, mesh.getVAO(), mesh.getAtlas()}, items.size()));
+  }
+  if (!snake.empty())
+  {
+    std::copy(snake.begin(), snake.end(),
+              queue.submit({LayerSnake, &shader, mesh.getVAO(), mesh.getAtlas()}, snake.size()));
+  }
+}
+
+Simulation::Simulation(Shader& shader, const GridInfo& gridInfo, GLuint inputDepth)
+    : shader(shader),
+      gridInfo(gridInfo),
+      arena(GameWorld::footprint(gridInfo)),
+      world(&GameWorld::create(arena, shader, gridInfo, threadRandom()())),
+      inputDepth(inputDepth)
+{
+  world->snake.setMoveDelay(moveDelay);
+  turns.reserve(inputDepth);
+
+  // Whichever snapshot a tick writes has room for the longest snake, so publishing never allocates
+  snapshots.prepare(
+      [&gridInfo](GameSnapshot& snapshot)
+      {
+        snapshot.items.reserve(5);  // food and big food
+        snapshot.snake.reserve(gridInfo.getCellCount());
+      });
+
+  // The first state is there before the thread starts
+  lastTick = SimClock::now();
+  nextTick = lastTick + toDuration(moveDelay);
+  publish();
+}
+
+Simulation::~Simulation() { stop(); }
+
+/**
+ * Starts ticking on the simulation thread.
+ */
+void Simulation::start()
+{
+  if (thread.joinable()) return;
+
+  stopping = false;
+  thread = std::thread(&Simulation::loop, this);
+}
+
+/**
+ * Stops the simulation thread, after the tick it may be in the middle of.
+ */
+void Simulation::stop()
+{
+  if (!thread.joinable()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  thread.join();
+}
+
+/**
+ * Hands a command to the simulation; it applies it before its next tick.
+ * Must only be called from one thread. Commands are dropped if the simulation is
+ * CommandQueueSize commands behind, which only happens when it has stopped.
+ * @param command The command to send.
+ */
+void Simulation::send(const SimCommand& command)
+{
+  if (!commands.push(command)) return;
+
+  // Taking the lock orders the push before the check the simulation makes before sleeping
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+  }
+  wake.notify_one();
+}
+
+/**
+ * Simulation thread: applies commands as they come in and ticks on schedule.
+ * Ticks are scheduled from the previous deadline, not from when the last one ran,
+ * so they never drift however late the thread gets woken.
+ */
+void Simulation::loop()
+{
+  Trace::nameThread("simulation");
+
+  while (!stopping)
+  {
+    bool changed{false};
+    SimCommand command;
+    while (commands.pop(command))
+    {
+      apply(command);
+      changed = true;
+    }
+
+    if (playing && SimClock::now() >= nextTick)
+    {
+      advance();
+    }
+    else if (changed)
+    {
+      publish();
+    }
+
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    const auto woken{[this] { return stopping || !commands.empty(); }};
+    if (playing)
+    {
+      wake.wait_until(lock, nextTick, woken);
+    }
+    else
+    {
+      wake.wait(lock, woken);
+    }
+  }
+}
+
+/**
+ * Runs ticks one after the other on the calling thread, ignoring the schedule.
+ * Only while the simulation thread is stopped. Stops early at game over.
+ * @param count Number of ticks.
+ */
+void Simulation::runTicks(GLuint count)
+{
+  for (GLuint i{0}; i < count && !gameOver; ++i) advance();
+}
+
+/**
+ * Applies one command from the render thread.
+ * @param command The command.
+ */
+void Simulation::apply(const SimCommand& command)
+{
+  const SimClock::time_point now{SimClock::now()};
+
+  switch (command.type)
+  {
+    case CommandTurn:
+      // A full buffer drops the newest turn, keeping the ones already lined up
+      if (turns.size() < inputDepth) turns.push_back({static_cast<int>(command.value), command.time});
+      break;
+
+    case CommandPause:
+      if (!playing) break;
+      pausedProgress = std::clamp(std::chrono::duration<GLfloat>(now - lastTick).count() / moveDelay, 0.0f, 1.0f);
+      playing = false;
+      break;
+
+    case CommandResume:
+      if (playing || gameOver) break;
+
+      // Carry on the move from where it was paused
+      nextTick = now + toDuration((1.0f - pausedProgress) * moveDelay);
+      lastTick = nextTick - toDuration(moveDelay);
+      playing = true;
+      break;
+
+    case CommandSetMoveDelay:
+      moveDelay = command.value;
+      world->snake.setMoveDelay(moveDelay);
+      nextTick = lastTick + toDuration(moveDelay);
+      break;
+
+    case CommandReset:
+      reset();
+      break;
+  }
+}
+
+/**
+ * Runs one tick: moves the snake a cell and resolves what it runs into.
+ */
+void Simulation::step()
+{
+  TRACE_SCOPE("tick");
+
+  lastTick = nextTick;
+  nextTick += toDuration(moveDelay);
+
+  // Stalled for more than a whole tick: skip the missed ones rather than rushing through them
+  const SimClock::time_point now{SimClock::now()};
+  if (nextTick <= now)
+  {
+    lastTick = now;
+    nextTick = now + toDuration(moveDelay);
+  }
+
+  ++tick;
+  takeTurn();
+  Snake& snake{world->snake};
+  if (autopilot) snake.setDirection(chooseDirection(snake, world->food.getPosition(), gridInfo));
+  const GLuint snakeAction{snake.stepAndEat(world->food, world->bigFood)};
+
+  if (snakeAction == 1 && autopilot)
+  {
+    reset();
+  }
+  else if (snakeAction == 1)
+  {
+    gameOver = true;
+    playing = false;
+    pausedProgress = 1.0f;
+  }
+  else if (snakeAction == 2)
+  {
+    score++;
+  }
+  else if (snakeAction == 3)
+  {
+    score += 2;
+    ++bigFoodHits;
+  }
+}
+
+/**
+ * A tick and the snapshot it publishes, counted in tickAllocations and timed in tickTimes.
+ */
+void Simulation::advance()
+{
+  AllocScope scope(tickAllocations);
+  TimingScope timing(tickTimes);
+  step();
+  publish();
+}
+
+/**
+ * Applies at most one buffered turn before a move. Turns made after this tick's deadline wait
+ * for the next one; turns that would reverse the snake or keep it going the same way are dropped.
+ */
+void Simulation::takeTurn()
+{
+  size_t taken{0};
+  while (taken < turns.size() && turns[taken].time <= lastTick)
+  {
+    const BufferedTurn& turn{turns[taken++]};
+    if (world->snake.canTurn(turn.direction))
+    {
+      world->snake.setDirection(turn.direction);
+      inputTime = turn.time;
+      inputAppliedTime = SimClock::now();
+      break;
+    }
+  }
+  turns.erase(turns.begin(), turns.begin() + static_cast<std::ptrdiff_t>(taken));
+}
+
+/**
+ * Starts a new game, at the current speed.
+ */
+void Simulation::reset()
+{
+  // Rewinding the arena drops the old snake and food at once, however long the game was
+  world = &GameWorld::create(arena, shader, gridInfo, threadRandom()());
+  world->snake.setMoveDelay(moveDelay);
+
+  turns.clear();
+  ++round;
+  tick = 0;
+  score = 0;
+  bigFoodHits = 0;
+  gameOver = false;
+  pausedProgress = 0.0f;
+  lastTick = SimClock::now();
+  nextTick = lastTick + toDuration(moveDelay);
+}
+
+/**
+ * Copies the current state into the triple buffer's back snapshot and publishes it.
+ * Only copies into storage reserved by the constructor.
+ */
+void Simulation::publish()
+{
+  TRACE_SCOPE("publish");
+
+  GameSnapshot& snapshot{snapshots.writeBuffer()};
+
+  snapshot.items.clear();
+  const Food& food{world->food};
+  for (size_t i{0}; i < food.getPosition().size(); ++i) snapshot.items.push_back(food.getCellInstance(i));
+
+  const BigFood& bigFood{world->bigFood};
+  snapshot.bigFoodActive = bigFood.isActive;
+  snapshot.bigFoodLife = snapshot.bigFoodActive ? bigFood.getLife() : 0.0f;
+  if (snapshot.bigFoodActive)
+  {
+    for (size_t i{0}; i < bigFood.getPosition().size(); ++i) snapshot.items.push_back(bigFood.getCellInstance(i));
+  }
+
+  snapshot.snake.clear();
+  const Snake& snake{world->snake};
+  for (size_t i{0}; i < snake.getSegments().size(); ++i) snapshot.snake.push_back(snake.getSegmentInstance(i));
+
+  // Spawns that were neither eaten nor still up ran out or were replaced by the next one
+  snapshot.seed = world->seed;
+  snapshot.bigFoodHits = bigFoodHits;
+  snapshot.bigFoodMisses = bigFood.getSpawnCount() - bigFoodHits - (bigFood.isActive ? 1 : 0);
+
+  snapshot.round = round;
+  snapshot.tick = tick;
+  snapshot.score = score;
+  snapshot.gameOver = gameOver;
+  snapshot.lastTick = lastTick;
+  snapshot.moveDelay = moveDelay;
+  snapshot.paused = !playing;
+  snapshot.pausedProgress = pausedProgress;
+  snapshot.inputTime = inputTime;
+  snapshot.inputAppliedTime = inputAppliedTime;
+
+  snapshots.publish();
+}
@@ -1,113 +1,162 @@
 #include "../include/snake.hpp"
 
 #include <SFML/Window/Event.hpp>
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <random>
 
 #include "../include/game.hpp"
 #include "../include/glad/glad.h"
-#include "../include/glm/gtc/type_ptr.hpp"
-#include "../include/render_engine.hpp"
-
-Snake::Snake(Shader& shaderProgram, const GridInfo& gridInfo)
-    : shaderProgram(shaderProgram), segments(generateSegments()), direction(1), gridInfo(gridInfo)
+#include "../include/sprite_atlas.hpp"
+
+Snake::Snake(Shader& shaderProgram, const GridInfo& gridInfo, Arena* arena, GameRandom* random)
+    : shaderProgram(shaderProgram),
+      gridInfo(gridInfo),
+      random(random),
+      segments(arena),
+      previousSegments(arena),
+      direction(1)
 {
+  // Room for a snake filling the whole grid, so moving and growing never allocate
+  segments.reserve(gridInfo.getCellCount());
+  previousSegments.reserve(gridInfo.getCellCount());
+
+  generateSegments(segments);
+  previousSegments = segments;
 }
 
 /**
  * Generates initial segments for the snake.
  * The snake starts with 3 segments positioned horizontally.
- * @return A vector of Cell representing the initial segments of the snake.
+ * @param out Gets the initial segments of the snake, in place of what it held.
  */
-std::vector<Cell> Snake::generateSegments()
+void Snake::generateSegments(CellList& out) const
 {
   auto [xMax, yMax]{gridInfo.getGridSizeI()};
 
-  static std::mt19937 gen(std::random_device{}());
+  GameRandom& gen{random ? *random : threadRandom()};
   std::uniform_int_distribution<int> distX(3, xMax - 3);
   std::uniform_int_distribution<int> distY(3, yMax - 3);
 
   int rN = distX(gen);
   int rN1 = distY(gen);
 
-  std::vector<Cell> newSegments;
-
-  for (int i{0}; i < 3; ++i) newSegments.push_back({rN - i, rN1});
-
-  return newSegments;
+  out.clear();
+  for (int i{0}; i < 3; ++i) out.push_back({rN - i, rN1});
 }
 
 /**
- * Draws the snake on the screen using OpenGL.
- * Each segment of the snake is drawn as a scaled and translated quad.
- * @param VAO The Vertex Array Object for the quad.
+ * Replaces the snake's segments, with no move in progress.
+ * @param segs The new segments, head first.
  */
-void Snake::draw(const GLuint& VAO) const
+void Snake::setSegments(const std::vector<Cell>& segs)
 {
-  shaderProgram.use();
-  glBindVertexArray(VAO);
+  // Copying in keeps the reserved capacity, and the storage in the game's arena
+  segments.assign(segs.begin(), segs.end());
+  previousSegments.assign(segs.begin(), segs.end());
+}
 
-  GLint modelLoc{glGetUniformLocation(shaderProgram.ID, "model")};
-  if (modelLoc == -1) std::cerr << "Warning: 'model' uniform not found in shader\n";
+/**
+ * On-screen direction from a cell to a neighbouring one, in clockwise quarter turns
+ * from right (0: right, 1: down, 2: left, 3: up), or -1 for the same cell.
+ * A step of more than one cell is a wraparound, which points the other way.
+ */
+static int stepDirection(const Cell& from, const Cell& to)
+{
+  int dx{to.x - from.x}, dy{to.y - from.y};
+  if (std::abs(dx) > 1) dx = dx > 0 ? -1 : 1;
+  if (std::abs(dy) > 1) dy = dy > 0 ? -1 : 1;
+
+  if (dx > 0) return 0;
+  if (dy > 0) return 1;
+  if (dx < 0) return 2;
+  if (dy < 0) return 3;
+  return -1;
+}
 
-  for (const auto& segment : getSegments())
-  {
-    glm::mat4 model{1.0f};
+/**
+ * Where a segment was on the previous move, where it is now, and how it looks.
+ * The sprite and its rotation follow from the neighbouring segments: a head facing away
+ * from the body, a tail pointing back at it, and straight or corner pieces in between.
+ * A segment added by grow() since the last move has no previous cell and stays put.
+ * @param index The segment index, 0 being the head.
+ */
+CellInstance Snake::getSegmentInstance(size_t index) const
+{
+  const Cell& current{segments[index]};
+  const Cell& previous{index < previousSegments.size() ? previousSegments[index] : current};
 
-    // Place each segment directly at its grid coordinate
-    model = glm::translate(model, glm::vec3(segment.x - 0.5f, segment.y - 0.5f, 0.0f));
+  // Towards the head and towards the tail; grown segments share a cell with the one before
+  int forward{-1}, backward{-1};
+  for (size_t i{index}; i > 0 && forward < 0; --i) forward = stepDirection(current, segments[i - 1]);
+  for (size_t i{index + 1}; i < segments.size() && backward < 0; ++i) backward = stepDirection(current, segments[i]);
 
-    // Scale each cell to 1.0 unit (each grid cell is 1 world unit)
-    model = glm::scale(model, scaleFactor * glm::vec3(1.0f));
+  GLuint sprite{SpriteBody};
+  int rotation{forward};
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  if (index == 0)
+  {
+    // Facing away from the neck, or the way it is heading when it has none
+    static const int headings[4]{1, 0, 3, 2};
+    sprite = SpriteHead;
+    rotation = backward >= 0 ? (backward + 2) % 4 : headings[direction];
+  }
+  else if (backward < 0)
+  {
+    sprite = SpriteTail;
+  }
+  else if (forward < 0)
+  {
+    rotation = (backward + 2) % 4;
+  }
+  else if (backward != (forward + 2) % 4)
+  {
+    // The corner sprite joins left (2) and bottom (1); turn it onto the two sides in use
+    sprite = SpriteCorner;
+    const int first{(forward + 1) % 4 == backward ? forward : backward};
+    rotation = (first + 3) % 4;
   }
-  glBindVertexArray(0);
+
+  return {static_cast<GLfloat>(previous.x), static_cast<GLfloat>(previous.y), static_cast<GLfloat>(current.x),
+          static_cast<GLfloat>(current.y),   sprite,
+          static_cast<GLuint>(std::max(rotation, 0))};
 }
 
 /**
- * Moves the snake in the current direction.
- * The snake moves one cell at a time based on the moveDelay.
+ * Moves the snake one cell in the current direction; called once per simulation tick.
  * The head of the snake moves in the specified direction, and each segment
  * follows the segment in front of it.
  */
-void Snake::move()
+void Snake::step()
 {
-  float deltaTime{clock.getElapsedTime().asSeconds()};
-
-  // Move the snake only if enough time has passed
-  if (deltaTime >= moveDelay)
-  {
-    clock.restart();
+  previousSegments = segments;
 
-    // move body
-    for (size_t i{segments.size() - 1}; i > 0; --i) segments[i] = segments[i - 1];
+  // move body
+  for (size_t i{segments.size() - 1}; i > 0; --i) segments[i] = segments[i - 1];
 
-    // move head    // Move the head
-    switch (direction)
-    {
-      case 0:
-        segments[0].y += 1;
-        break;  // Up
-      case 1:
-        segments[0].x += 1;
-        break;  // Right
-      case 2:
-        segments[0].y -= 1;
-        break;  // Down
-      case 3:
-        segments[0].x -= 1;
-        break;  // Left
-      default:
-        break;
-    }
+  // move head    // Move the head
+  switch (direction)
+  {
+    case 0:
+      segments[0].y += 1;
+      break;  // Up
+    case 1:
+      segments[0].x += 1;
+      break;  // Right
+    case 2:
+      segments[0].y -= 1;
+      break;  // Down
+    case 3:
+      segments[0].x -= 1;
+      break;  // Left
+    default:
+      break;
   }
 }
 
 /**
- * Moves the snake, and eat food it comes contact with.
- * @param renderEngine Reference to the current running render engine.
+ * Moves the snake one cell, and eats food it comes in contact with.
  * @param food Reference to food instance.
  * @param bigFood Reference to big food instance.
  * @return 0 if movement and eating is happening without collision.
@@ -115,11 +164,19 @@ void Snake::move()
  *         2 if snake just ate normal food,
  *         3 if snake just ate big food.
  */
-GLuint Snake::moveAndEat(RenderEngine& renderEngine, Food& food, std::unique_ptr<BigFood>& bigFood)
+GLuint Snake::stepAndEat(Food& food, BigFood& bigFood)
 {
-  // start moving the snake
-  move();
+  step();
+
+  return eat(food, bigFood);
+}
 
+/**
+ * Resolves the snake's current position: collision, edge wrapping and eating.
+ * @return See stepAndEat.
+ */
+GLuint Snake::eat(Food& food, BigFood& bigFood)
+{
   // Check for collision
   if (isCollided())
   {
@@ -129,8 +186,8 @@ GLuint Snake::moveAndEat(RenderEngine& renderEngine, Food& food, std::unique_ptr
   // allow for snake movement to wrap around edges
   mirrorEdges();
 
-  // timer for big food if available
-  if (bigFood && bigFood->isActive) bigFood->startCounting(moveDelay);
+  // big food lasts a number of ticks, whatever the speed
+  if (bigFood.isActive) bigFood.tick();
 
   // Check if the snake has eaten the food
   if (isEating(food.getPosition()))
@@ -144,19 +201,17 @@ GLuint Snake::moveAndEat(RenderEngine& renderEngine, Food& food, std::unique_ptr
     if (food.getRespawnCounter() % 4 == 0 && food.getRespawnCounter())
     {
       // std::cout << "Big Food Spawned!\n";
-      bigFood = std::make_unique<BigFood>(shaderProgram, renderEngine.getGridInfo());
-      bigFood->isActive = true;
-      renderEngine.setBigFood(bigFood.get());
+      bigFood.spawn();
     }
 
     return 2;
   }
 
   // check if snake has eaten big food
-  else if (bigFood && bigFood->isActive && isEating(bigFood->getPosition()))
+  else if (bigFood.isActive && isEating(bigFood.getPosition()))
   {
     grow();
-    bigFood->isActive = false;
+    bigFood.isActive = false;
 
     return 3;
   }
@@ -172,36 +227,28 @@ GLuint Snake::moveAndEat(RenderEngine& renderEngine, Food& food, std::unique_ptr
 void Snake::setDirection(int dir)
 {
   // Prevent the snake from reversing
-  if ((direction == 0 && dir != 2) || (direction == 1 && dir != 3) || (direction == 2 && dir != 0) ||
-      (direction == 3 && dir != 1))
-  {
-    direction = dir;
-  }
+  if (canTurn(dir)) direction = dir;
 }
 
 /**
- * Attaches keyboard controls to change the snake's direction.
- * Maps arrow keys to corresponding directions.
- * @param keyPressed The key press event to handle.
+ * Maps the arrow keys to the direction they steer the snake in.
+ * @param keyPressed The key press event to map.
+ * @return The direction for setDirection, or -1 for any other key.
  */
-void Snake::attachControl(const sf::Event::KeyPressed& keyPressed)
+int Snake::getKeyDirection(const sf::Event::KeyPressed& keyPressed)
 {
   switch (keyPressed.scancode)
   {
     case sf::Keyboard::Scan::Right:
-      setDirection(1);
-      break;
+      return 1;
     case sf::Keyboard::Scan::Left:
-      setDirection(3);
-      break;
+      return 3;
     case sf::Keyboard::Scan::Up:
-      setDirection(2);
-      break;
+      return 2;
     case sf::Keyboard::Scan::Down:
-      setDirection(0);
-      break;
+      return 0;
     default:
-      break;
+      return -1;
   }
 }
 
@@ -210,7 +257,7 @@ void Snake::attachControl(const sf::Event::KeyPressed& keyPressed)
  * @param foodPosition The position of the food.
  * @return True if the snake is eating the food, false otherwise.
  */
-bool Snake::isEating(const std::vector<Cell>& foodPosition) const
+bool Snake::isEating(const CellList& foodPosition) const
 {
   const auto& head{getHead()};
   // std::cout << "[isEating] Head: (" << head.x << ", " << head.y << ")\n";
@@ -288,6 +335,8 @@ bool Snake::isCollided() const
  */
 void Snake::reset()
 {
-  setSegments(generateSegments());
+  generateSegments(segments);
+  previousSegments = segments;
+  direction = 1;  // new segments are laid out heading right
   setMoveDelay(Game::GameSpeed);
 }
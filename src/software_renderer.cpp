@@ -0,0 +1,266 @@
+#include "../include/software_renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "../include/image.hpp"
+#include "../include/sprite_atlas.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SNAKE_SPAN_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SNAKE_SPAN_NEON
+#endif
+
+// Packs bytes in memory order, so the framebuffer is plain RGBA8 on any endianness
+static uint32_t packColor(unsigned char r, unsigned char g, unsigned char b)
+{
+  const unsigned char bytes[4]{r, g, b, 255};
+  uint32_t color;
+  std::memcpy(&color, bytes, sizeof(color));
+  return color;
+}
+
+// Same color as RenderEngine::clearScreen
+static const uint32_t backgroundColor{packColor(51, 76, 76)};
+
+/**
+ * Fills count pixels starting at dst with one color, four (or eight) pixels per store.
+ */
+static void fillSpan(uint32_t* dst, int count, uint32_t color)
+{
+#if defined(SNAKE_SPAN_SSE2)
+  const __m128i value{_mm_set1_epi32(static_cast<int>(color))};
+  for (; count >= 8; count -= 8, dst += 8)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), value);
+  }
+  for (; count >= 4; count -= 4, dst += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+#elif defined(SNAKE_SPAN_NEON)
+  const uint32x4_t value{vdupq_n_u32(color)};
+  for (; count >= 4; count -= 4, dst += 4) vst1q_u32(dst, value);
+#endif
+  for (; count > 0; --count) *dst++ = color;
+}
+
+/**
+ * @param size Framebuffer dimensions (width, height).
+ * @param gridInfo Grid the scene is laid out on.
+ * @param threadCount Threads drawing tiles, including the caller. 0 = one per hardware thread.
+ */
+SoftwareRenderer::SoftwareRenderer(const ScreenSize& size, const GridInfo& gridInfo, unsigned threadCount)
+    : gridInfo(gridInfo),
+      width(size.first),
+      height(size.second),
+      tilesX((size.first + TileSize - 1) / TileSize),
+      tilesY((size.second + TileSize - 1) / TileSize),
+      pixels(static_cast<size_t>(size.first) * size.second, backgroundColor),
+      bins(tilesX * tilesY)
+{
+  if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  // No point in more threads than tiles; the calling thread draws too
+  threadCount = std::min(threadCount, tilesX * tilesY);
+  for (unsigned i{1}; i < threadCount; ++i)
+  {
+    workers.emplace_back(&SoftwareRenderer::workerLoop, this);
+  }
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+
+  for (auto& worker : workers) worker.join();
+}
+
+/**
+ * Renders one frame of a simulation snapshot: the snake, the food, and the big food when active.
+ * Cells are drawn exactly like RenderEngine does: a quad scaled by scaleFactor around
+ * (x - 0.5, y - 0.5), under an orthographic projection with Y pointing down, with the
+ * snake interpolated between its last two moves.
+ * @param snapshot The state to draw.
+ * @param alpha How far the snake is between its last two moves.
+ */
+void SoftwareRenderer::render(const GameSnapshot& snapshot, GLfloat alpha)
+{
+  rects.clear();
+  for (auto& bin : bins) bin.clear();
+
+  // Same order as the render queue: items, then the snake on top
+  for (const auto& cell : snapshot.items) addCell(cell, alpha);
+  for (const auto& cell : snapshot.snake) addCell(cell, alpha);
+
+  // Kick the workers and help out until every tile is drawn
+  nextTile = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++generation;
+    busyWorkers = static_cast<unsigned>(workers.size());
+  }
+  wake.notify_all();
+
+  drawTiles();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+/**
+ * Converts a cell quad to a pixel rectangle and bins it into the tiles it touches.
+ * @param cell The cell, with its sprite.
+ * @param alpha How far to place it between its previous and current position.
+ */
+void SoftwareRenderer::addCell(const CellInstance& cell, GLfloat alpha)
+{
+  auto [xMax, yMax]{gridInfo.getGridSizeF()};
+  const float pixelsPerCellX{width / xMax};
+  const float pixelsPerCellY{height / yMax};
+  const float halfSize{scaleFactor * 0.5f};
+
+  auto [x, y]{cell.interpolate(alpha, gridInfo.getWrapSize())};
+  const float centerX{x - 0.5f};
+  const float centerY{y - 0.5f};
+
+  // A pixel is covered when its center lies inside the quad, as with GL rasterization
+  Rect rect{static_cast<int>(std::ceil((centerX - halfSize) * pixelsPerCellX - 0.5f)),
+            static_cast<int>(std::ceil((centerY - halfSize) * pixelsPerCellY - 0.5f)),
+            static_cast<int>(std::ceil((centerX + halfSize) * pixelsPerCellX - 0.5f)),
+            static_cast<int>(std::ceil((centerY + halfSize) * pixelsPerCellY - 0.5f)),
+            (centerX - halfSize) * pixelsPerCellX,
+            (centerY - halfSize) * pixelsPerCellY,
+            scaleFactor * pixelsPerCellX,
+            cell.sprite,
+            cell.rotation};
+
+  rect.x0 = std::max(rect.x0, 0);
+  rect.y0 = std::max(rect.y0, 0);
+  rect.x1 = std::min(rect.x1, static_cast<int>(width));
+  rect.y1 = std::min(rect.y1, static_cast<int>(height));
+  if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1) return;
+
+  const auto index{static_cast<uint32_t>(rects.size())};
+  rects.push_back(rect);
+
+  for (int ty{rect.y0 / static_cast<int>(TileSize)}; ty <= (rect.y1 - 1) / static_cast<int>(TileSize); ++ty)
+  {
+    for (int tx{rect.x0 / static_cast<int>(TileSize)}; tx <= (rect.x1 - 1) / static_cast<int>(TileSize); ++tx)
+    {
+      bins[ty * tilesX + tx].push_back(index);
+    }
+  }
+}
+
+/**
+ * Draws tiles until none are left. Runs on the render thread and every worker.
+ */
+void SoftwareRenderer::drawTiles()
+{
+  const GLuint tileCount{tilesX * tilesY};
+  for (GLuint tile{nextTile++}; tile < tileCount; tile = nextTile++)
+  {
+    drawTile(tile);
+  }
+}
+
+/**
+ * Clears one tile and draws the parts of its binned rectangles that fall inside it.
+ * Sprite texels are cut out like in fragment.glsl: transparent ones leave what is below.
+ * @param tile Tile index, row-major.
+ */
+void SoftwareRenderer::drawTile(GLuint tile)
+{
+  const int tileX0{static_cast<int>((tile % tilesX) * TileSize)};
+  const int tileY0{static_cast<int>((tile / tilesX) * TileSize)};
+  const int tileX1{std::min(tileX0 + static_cast<int>(TileSize), static_cast<int>(width))};
+  const int tileY1{std::min(tileY0 + static_cast<int>(TileSize), static_cast<int>(height))};
+
+  for (int y{tileY0}; y < tileY1; ++y)
+  {
+    fillSpan(&pixels[static_cast<size_t>(y) * width + tileX0], tileX1 - tileX0, backgroundColor);
+  }
+
+  constexpr GLuint SpriteSize{SpriteAtlas::SpriteSize};
+  uint32_t texels[SpriteSize];
+  for (uint32_t index : bins[tile])
+  {
+    const Rect& rect{rects[index]};
+    const int x0{std::max(rect.x0, tileX0)};
+    const int x1{std::min(rect.x1, tileX1)};
+    const int y0{std::max(rect.y0, tileY0)};
+    const int y1{std::min(rect.y1, tileY1)};
+    const float texelSize{rect.size / SpriteSize};
+
+    // Pixel column where each texel column of the quad starts, nearest sampled like GL_NEAREST
+    int columns[SpriteSize + 1];
+    for (GLuint i{0}; i <= SpriteSize; ++i)
+    {
+      columns[i] = std::clamp(static_cast<int>(std::ceil(rect.left + i * texelSize - 0.5f)), x0, x1);
+    }
+    columns[0] = x0;
+    columns[SpriteSize] = x1;
+
+    for (int y{y0}; y < y1; ++y)
+    {
+      const int texelRow{std::clamp(static_cast<int>((y + 0.5f - rect.top) / texelSize), 0,
+                                    static_cast<int>(SpriteSize) - 1)};
+      SpriteAtlas::readRow(rect.sprite, rect.rotation, static_cast<GLuint>(texelRow), texels);
+      uint32_t* row{&pixels[static_cast<size_t>(y) * width]};
+
+      // Runs of one texel color are a single span fill; transparent ones leave what is below
+      for (GLuint i{0}; i < SpriteSize;)
+      {
+        GLuint end{i + 1};
+        while (end < SpriteSize && texels[end] == texels[i]) ++end;
+        if (reinterpret_cast<const unsigned char*>(&texels[i])[3] >= 128)
+        {
+          fillSpan(&row[columns[i]], columns[end] - columns[i], texels[i]);
+        }
+        i = end;
+      }
+    }
+  }
+}
+
+/**
+ * Worker thread: waits for a new frame, draws tiles, reports back.
+ */
+void SoftwareRenderer::workerLoop()
+{
+  unsigned seenGeneration{0};
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+      if (stopping) return;
+      seenGeneration = generation;
+    }
+
+    drawTiles();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--busyWorkers == 0) done.notify_one();
+    }
+  }
+}
+
+/**
+ * Writes the last rendered frame as a PPM image.
+ * @param path The file to write.
+ * @return True on success.
+ */
+bool SoftwareRenderer::saveFrame(const std::string& path) const
+{
+  return writePPM(path, width, height, reinterpret_cast<const unsigned char*>(pixels.data()));
+}
@@ -0,0 +1,346 @@
+#include "../include/spectator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+
+#include "../include/autopilot.hpp"
+#include "../include/glm/gtc/type_ptr.hpp"
+#include "../include/sprite_atlas.hpp"
+#include "../include/trace.hpp"
+
+/**
+ * Opens the surface, creates the games and starts simulating them.
+ * @param options Launch options; spectateGames sets the number of games.
+ */
+Spectator::Spectator(const LaunchOptions& options)
+    : options(options), screenSize{options.getScreenSize()}
+{
+  surface = Surface::create(options, screenSize, "SNAKE GAME - SPECTATOR");
+  if (!surface) throw std::runtime_error("Spectator mode needs an OpenGL surface");
+
+  Shader::enableParallelCompile(surface->getLoader());
+  const ShaderSource source{ShaderSource::load()};
+  shaderProgram = std::make_unique<Shader>(source, Shader::defaultCacheDir());
+  tileShader = std::make_unique<Shader>(source, Shader::defaultCacheDir());
+
+  // Bot runs are only kept when asked for, to not crowd out the player's
+  Leaderboard* runs{nullptr};
+  if (!options.leaderboardPath.empty() && leaderboard.open(options.leaderboardPath)) runs = &leaderboard;
+
+  TelemetryWriter* records{nullptr};
+  if (!options.telemetryPath.empty() && telemetry.open(options.telemetryPath)) records = &telemetry;
+
+  for (GLuint i{0}; i < options.spectateGames; ++i)
+  {
+    games.push_back(std::make_unique<SimGame>(simShader, runs, records));
+  }
+
+  // Lay the tiles out to roughly match the window's aspect ratio
+  const GLfloat aspectRatio{static_cast<GLfloat>(screenSize.first) / screenSize.second};
+  columns = static_cast<GLuint>(std::ceil(std::sqrt(options.spectateGames * aspectRatio)));
+  columns = std::min(columns, options.spectateGames);
+  rows = (options.spectateGames + columns - 1) / columns;
+  tileSpan = games.front()->gridInfo.getWrapSize().first + TileGap;
+
+  mesh.create();
+  setupCoordinates();
+
+  // Every game gets a first snapshot before anything is drawn
+  for (auto& game : games) game->tick();
+
+  const unsigned threadCount{std::min<unsigned>(std::max(1u, std::thread::hardware_concurrency()),
+                                                static_cast<unsigned>(games.size()))};
+  for (unsigned i{0}; i < threadCount; ++i) workerStats.push_back(std::make_unique<WorkerStats>());
+  for (unsigned i{0}; i < threadCount; ++i) workers.emplace_back(&Spectator::simulate, this, i, threadCount);
+
+  if (options.metricsPort)
+  {
+    metrics = std::make_unique<MetricsServer>(static_cast<uint16_t>(options.metricsPort),
+                                              [this](MetricsWriter& out) { writeMetrics(out); });
+  }
+}
+
+Spectator::~Spectator()
+{
+  metrics.reset();
+  stopping = true;
+  for (auto& worker : workers) worker.join();
+
+  if (surface->isOpen()) mesh.destroy();
+}
+
+/**
+ * Simulation thread: steps every stride-th game, starting at first, once per TickInterval.
+ */
+void Spectator::simulate(size_t first, size_t stride)
+{
+  const auto interval{std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<GLfloat>(TickInterval))};
+  auto nextTick{std::chrono::steady_clock::now() + interval};
+  Trace::nameThread("spectator simulation");
+  WorkerStats& stats{*workerStats[first]};
+
+  while (!stopping)
+  {
+    std::this_thread::sleep_until(nextTick);
+    nextTick += interval;
+
+    TRACE_SCOPE("tick");
+    AllocScope allocations(stats.allocations);
+    TimingScope timing(stats.rounds);
+    uint64_t ticked{0}, ended{0};
+    for (size_t i{first}; i < games.size(); i += stride)
+    {
+      if (games[i]->tick()) ++ended;
+      ++ticked;
+    }
+    stats.ticks.fetch_add(ticked, std::memory_order_relaxed);
+    stats.games.fetch_add(ended, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * One scrape of the metrics endpoint, on its thread: games and ticks per simulation thread,
+ * how busy each one is, and how long their rounds and the frames take.
+ * @param out The scrape.
+ */
+void Spectator::writeMetrics(MetricsWriter& out)
+{
+  const auto worker{[](size_t i) { return "worker=\"" + std::to_string(i) + "\""; }};
+
+  for (size_t i{0}; i < workerStats.size(); ++i)
+  {
+    out.counter("snake_games_total", "Bot games finished.",
+                static_cast<double>(workerStats[i]->games.load(std::memory_order_relaxed)), worker(i));
+  }
+  for (size_t i{0}; i < workerStats.size(); ++i)
+  {
+    out.counter("snake_ticks_total", "Simulation ticks run, one per game per round.",
+                static_cast<double>(workerStats[i]->ticks.load(std::memory_order_relaxed)), worker(i));
+  }
+  out.counter("snake_frames_total", "Frames rendered.", static_cast<double>(frameTimes.getCount()));
+
+  // rate() of this is each thread's utilization
+  for (size_t i{0}; i < workerStats.size(); ++i)
+  {
+    const TimingHistogram::Summary rounds{workerStats[i]->rounds.summarize()};
+    out.counter("snake_worker_busy_seconds_total", "Time a thread spent working rather than waiting.",
+                rounds.mean * rounds.count / 1000.0, worker(i));
+  }
+
+  if (telemetry.isOpen())
+  {
+    out.gauge("snake_queue_depth", "Items waiting in a queue between threads.",
+              static_cast<double>(telemetry.getPending()), "queue=\"telemetry\"");
+  }
+
+  for (size_t i{0}; i < workerStats.size(); ++i)
+  {
+    out.summary("snake_round_seconds", "Time for a simulation thread to tick each of its games once.",
+                workerStats[i]->rounds, worker(i));
+  }
+  out.summary("snake_frame_seconds", "Time to render a frame, display() included.", frameTimes);
+
+  if (AllocTracker::Enabled)
+  {
+    // Counted per thread, so only summed here
+    AllocCounter total;
+    for (const auto& stats : workerStats)
+    {
+      total.allocations += stats->allocations.allocations.load();
+      total.bytes += stats->allocations.bytes.load();
+      total.peak = std::max(total.peak.load(), stats->allocations.peak.load());
+    }
+    out.allocations({{"round", &total}});
+  }
+}
+
+/**
+ * Steps one game: the bot steers, the snake moves, a dead snake is recorded and starts over.
+ * Then publishes the cells to draw.
+ * @return Whether the game ended.
+ */
+bool Spectator::SimGame::tick()
+{
+  Snake& snake{world->snake};
+  snake.setDirection(chooseDirection(snake, world->food.getPosition(), gridInfo));
+
+  ++ticks;
+  const GLuint action{snake.stepAndEat(world->food, world->bigFood)};
+  if (action == 2) score += 1;
+  if (action == 3)
+  {
+    score += 2;
+    ++bigFoodHits;
+  }
+
+  if (action == 1)
+  {
+    if (leaderboard)
+    {
+      leaderboard->add(score, static_cast<uint32_t>(snake.getSegments().size()), ticks, Leaderboard::SourceBot);
+    }
+    if (telemetry)
+    {
+      const auto [xMax, yMax]{gridInfo.getGridSizeI()};
+      GameRecord record;
+      record.endTime = static_cast<uint64_t>(std::time(nullptr));
+      record.seed = world->seed;
+      record.agent = AgentBot;
+      record.gridWidth = static_cast<uint16_t>(xMax + 1);
+      record.gridHeight = static_cast<uint16_t>(yMax + 1);
+      record.difficulty = 4;  // bots play at their own pace
+      record.moveDelay = TickInterval;
+      record.length = static_cast<uint32_t>(snake.getSegments().size());
+      record.score = score;
+      record.ticks = ticks;
+      record.deathCause = DeathCollision;
+      record.bigFoodHits = bigFoodHits;
+      record.bigFoodMisses = world->bigFood.getSpawnCount() - bigFoodHits - (world->bigFood.isActive ? 1 : 0);
+      telemetry->add(record);
+    }
+
+    // A fresh world is a rewind of the game's arena
+    world = &GameWorld::create(arena, shader, gridInfo, threadRandom()());
+    score = ticks = bigFoodHits = 0;
+  }
+
+  std::vector<CellInstance>& cells{snapshot.writeBuffer()};
+  cells.clear();
+
+  const GameWorld& game{*world};
+  for (size_t i{0}; i < game.snake.getSegments().size(); ++i) cells.push_back(game.snake.getSegmentInstance(i));
+
+  const Food& food{game.food};
+  const BigFood& bigFood{game.bigFood};
+  for (size_t i{0}; i < food.getPosition().size(); ++i) cells.push_back(food.getCellInstance(i));
+  if (bigFood.isActive)
+  {
+    for (size_t i{0}; i < bigFood.getPosition().size(); ++i) cells.push_back(bigFood.getCellInstance(i));
+  }
+
+  snapshot.publish();
+  return action == 1;
+}
+
+/**
+ * Projects the whole tile grid onto the screen, keeping cells square.
+ */
+void Spectator::setupCoordinates()
+{
+  auto [width, height]{surface->getSize()};
+  const GLfloat aspectRatio{static_cast<GLfloat>(width) / height};
+
+  // Tiles span [0, columns * tileSpan] x [0, rows * tileSpan]; center them
+  const GLfloat gridWidth{columns * tileSpan}, gridHeight{rows * tileSpan};
+  const GLfloat viewWidth{std::max(gridWidth, gridHeight * aspectRatio)};
+  const GLfloat viewHeight{std::max(gridHeight, gridWidth / aspectRatio)};
+  const GLfloat left{(gridWidth - viewWidth) * 0.5f}, top{(gridHeight - viewHeight) * 0.5f};
+
+  glm::mat4 view{1.0f};
+  glm::mat4 projection{glm::ortho(left, left + viewWidth,  // left, right
+                                  top + viewHeight, top,   // top, bottom (flip Y)
+                                  -1.0f, 1.0f)};
+  auto [wrapX, wrapY]{games.front()->gridInfo.getWrapSize()};
+
+  for (Shader* shader : {shaderProgram.get(), tileShader.get()})
+  {
+    shader->use(glState);
+    glUniformMatrix4fv(glGetUniformLocation(shader->ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(shader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+    // Snapshots are drawn where they are, no interpolation between ticks
+    shader->setFloat("alpha", 1.0f);
+    glUniform2f(glGetUniformLocation(shader->ID, "wrapSize"), wrapX, wrapY);
+  }
+
+  shaderProgram->use(glState);
+  shaderProgram->setFloat("scale", scaleFactor);
+
+  // One quad per tile in the background color, leaving a one cell frame between tiles
+  tileShader->use(glState);
+  tileShader->setFloat("scale", tileSpan - TileGap + 1.0f);
+  glUniform4f(glGetUniformLocation(tileShader->ID, "color"), 0.2f, 0.3f, 0.3f, 1.0f);
+}
+
+/**
+ * Draws the latest snapshot of every game into its tile.
+ * The render queue merges the packets into two draws: every tile background, then every cell.
+ */
+void Spectator::render()
+{
+  TRACE_SCOPE("draw tiles");
+
+  // The frame between tiles; tiles draw their own background
+  glClearColor(0.1f, 0.15f, 0.15f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  const GLfloat tileCenter{(tileSpan - TileGap) * 0.5f};
+
+  for (size_t i{0}; i < games.size(); ++i)
+  {
+    auto& snapshot{games[i]->snapshot};
+    snapshot.update();
+    const std::vector<CellInstance>& cells{snapshot.read()};
+
+    // Cell 0 sits half a cell left of its tile, shift by one to keep it inside
+    const GLfloat offsetX{(i % columns) * tileSpan + 1.0f};
+    const GLfloat offsetY{(i / columns) * tileSpan + 1.0f};
+
+    const GLfloat tileX{offsetX - 0.5f + tileCenter}, tileY{offsetY - 0.5f + tileCenter};
+    *renderQueue.submit({LayerBackground, tileShader.get(), mesh.getVAO(), mesh.getAtlas()}, 1) = {
+        tileX, tileY, tileX, tileY, SpriteSolid};
+
+    CellInstance* instances{
+        renderQueue.submit({LayerSnake, shaderProgram.get(), mesh.getVAO(), mesh.getAtlas()}, cells.size())};
+    for (const auto& cell : cells)
+    {
+      *instances++ = {cell.previousX + offsetX, cell.previousY + offsetY, cell.x + offsetX, cell.y + offsetY,
+                      cell.sprite, cell.rotation};
+    }
+  }
+
+  renderQueue.flush(mesh.getInstanceVBO(), glState);
+}
+
+/**
+ * Renders until the window is closed, or for the requested number of frames.
+ */
+void Spectator::run()
+{
+  while (surface->isOpen() && !Surface::isInterrupted())
+  {
+    TimingScope timing(frameTimes);
+    while (const std::optional<sf::Event> event{surface->pollEvent()})
+    {
+      if (event->is<sf::Event::Closed>()) surface->close();
+
+      if (event->is<sf::Event::Resized>())
+      {
+        auto [width, height]{surface->getSize()};
+        glViewport(0, 0, width, height);
+        setupCoordinates();
+      }
+    }
+    if (!surface->isOpen()) break;
+
+    render();
+
+    // Fixed-length runs (offscreen captures) stop here
+    if (options.frames && ++frameCount >= options.frames)
+    {
+      if (!options.outputPath.empty() && !surface->saveFrame(options.outputPath))
+      {
+        std::cerr << "Failed to write " << options.outputPath << std::endl;
+      }
+      surface->close();
+    }
+
+    TRACE_SCOPE("display");
+    surface->display();
+  }
+}
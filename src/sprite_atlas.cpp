@@ -0,0 +1,181 @@
+#include "../include/sprite_atlas.hpp"
+
+#include <cmath>
+#include <cstring>
+
+// Packs bytes in memory order, so the atlas is plain RGBA8 on any endianness
+static uint32_t packColor(unsigned char r, unsigned char g, unsigned char b, unsigned char a = 255)
+{
+  const unsigned char bytes[4]{r, g, b, a};
+  uint32_t color;
+  std::memcpy(&color, bytes, sizeof(color));
+  return color;
+}
+
+namespace
+{
+const uint32_t clear{packColor(0, 0, 0, 0)};
+const uint32_t white{packColor(255, 255, 255)};
+const uint32_t orange{packColor(255, 128, 51)};  // the original cell color
+const uint32_t darkOrange{packColor(204, 92, 31)};
+const uint32_t eye{packColor(30, 30, 30)};
+const uint32_t food{packColor(230, 57, 70)};
+const uint32_t foodShine{packColor(255, 170, 170)};
+const uint32_t bigFood{packColor(255, 200, 40)};
+const uint32_t bigFoodRing{packColor(230, 140, 20)};
+
+// Paints one sprite; f gets texel centers in [0, SpriteSize) and returns the texel color
+template <typename Paint>
+void paint(std::vector<uint32_t>& atlas, GLuint sprite, Paint f)
+{
+  const GLuint x0{(sprite % SpriteAtlas::Columns) * SpriteAtlas::SpriteSize};
+  const GLuint y0{(sprite / SpriteAtlas::Columns) * SpriteAtlas::SpriteSize};
+
+  for (GLuint y{0}; y < SpriteAtlas::SpriteSize; ++y)
+  {
+    for (GLuint x{0}; x < SpriteAtlas::SpriteSize; ++x)
+    {
+      atlas[(y0 + y) * SpriteAtlas::Size + x0 + x] = f(x + 0.5f, y + 0.5f);
+    }
+  }
+}
+
+// Snake band running through the middle of a sprite, with a darker outline
+uint32_t band(float across)
+{
+  const float half{SpriteAtlas::SpriteSize * 0.5f};
+  const float distance{std::abs(across - half)};
+  if (distance > half - 2.0f) return clear;
+  return distance > half - 3.5f ? darkOrange : orange;
+}
+
+std::vector<uint32_t> generate()
+{
+  std::vector<uint32_t> atlas(SpriteAtlas::Size * SpriteAtlas::Size, clear);
+  const float size{static_cast<float>(SpriteAtlas::SpriteSize)};
+  const float half{size * 0.5f};
+
+  paint(atlas, SpriteSolid, [](float, float) { return white; });
+
+  paint(atlas, SpriteBody, [](float, float y) { return band(y); });
+
+  // Band from the left edge turning down to the bottom edge, around the bottom left corner
+  paint(atlas, SpriteCorner,
+        [&](float x, float y)
+        {
+          const float radius{std::hypot(x, y - size)};
+          return band(radius);
+        });
+
+  // Rounded snout on the right, two eyes
+  paint(atlas, SpriteHead,
+        [&](float x, float y)
+        {
+          if (std::abs(x - size * 0.7f) < 1.5f && std::abs(std::abs(y - half) - 3.0f) < 1.0f) return eye;
+          if (x <= half) return band(y);
+
+          const float radius{std::hypot(x - half, y - half)};
+          if (radius > half - 2.0f) return clear;
+          return radius > half - 3.5f ? darkOrange : orange;
+        });
+
+  // Narrowing towards the left end
+  paint(atlas, SpriteTail,
+        [&](float x, float y)
+        {
+          const float width{2.0f + (half - 4.0f) * x / size};
+          const float distance{std::abs(y - half)};
+          if (distance > width) return clear;
+          return distance > width - 1.5f ? darkOrange : orange;
+        });
+
+  paint(atlas, SpriteFood,
+        [&](float x, float y)
+        {
+          if (std::hypot(x - half * 0.75f, y - half * 0.75f) < 1.5f) return foodShine;
+          return std::hypot(x - half, y - half) < half - 2.0f ? food : clear;
+        });
+
+  // One big disc across the 2x2 big food, a quarter per sprite
+  for (GLuint quarter{0}; quarter < 4; ++quarter)
+  {
+    const float offsetX{(quarter % 2) * size}, offsetY{(quarter / 2) * size};
+    paint(atlas, SpriteBigFood + quarter,
+          [&](float x, float y)
+          {
+            const float radius{std::hypot(x + offsetX - size, y + offsetY - size)};
+            if (radius > size - 2.0f) return clear;
+            return radius > size - 4.0f ? bigFoodRing : bigFood;
+          });
+  }
+
+  return atlas;
+}
+}  // namespace
+
+const std::vector<uint32_t>& SpriteAtlas::getPixels()
+{
+  static const std::vector<uint32_t> pixels{generate()};
+  return pixels;
+}
+
+/**
+ * Uploads the atlas as a texture. Nearest filtering keeps the pixel art crisp and
+ * stops neighbouring sprites from bleeding in.
+ * @return The texture name.
+ */
+GLuint SpriteAtlas::createTexture()
+{
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, Size, Size, 0, GL_RGBA, GL_UNSIGNED_BYTE, getPixels().data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture;
+}
+
+/**
+ * Reads the texels a row of a quad shows, the way the shaders rotate and sample the sprite.
+ * @param sprite The sprite.
+ * @param rotation Clockwise quarter turns.
+ * @param row Texel row across the quad, 0 at the top, below SpriteSize.
+ * @param texels Receives SpriteSize RGBA8 texels, from the quad's left edge to its right.
+ */
+void SpriteAtlas::readRow(GLuint sprite, GLuint rotation, GLuint row, uint32_t* texels)
+{
+  const uint32_t* origin{&getPixels()[(sprite / Columns) * SpriteSize * Size + (sprite % Columns) * SpriteSize]};
+  constexpr GLuint Last{SpriteSize - 1};
+
+  // Texel (x, y) of the sprite that column i of the quad shows, after the quarter turns
+  for (GLuint i{0}; i < SpriteSize; ++i)
+  {
+    GLuint x, y;
+    switch (rotation % 4)
+    {
+      case 0:
+        x = i;
+        y = row;
+        break;
+      case 1:
+        x = row;
+        y = Last - i;
+        break;
+      case 2:
+        x = Last - i;
+        y = Last - row;
+        break;
+      default:
+        x = Last - row;
+        y = i;
+        break;
+    }
+    texels[i] = origin[y * Size + x];
+  }
+}
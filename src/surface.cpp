@@ -0,0 +1,109 @@
+#include "../include/surface.hpp"
+
+#include <SFML/Window/Context.hpp>
+#include <SFML/Window/VideoMode.hpp>
+#include <SFML/Window/WindowEnums.hpp>
+#include <csignal>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/gl_profiler.hpp"
+#include "../include/glad/glad.h"
+#ifdef SNAKE_HEADLESS
+#include "../include/headless_surface.hpp"
+#endif
+#include "../include/image.hpp"
+
+namespace
+{
+volatile std::sig_atomic_t interrupted{0};
+
+extern "C" void onInterrupt(int) { interrupted = 1; }
+}  // namespace
+
+/**
+ * Turns SIGINT and SIGTERM into a request to stop, see isInterrupted().
+ */
+void Surface::catchInterrupts()
+{
+  std::signal(SIGINT, onInterrupt);
+  std::signal(SIGTERM, onInterrupt);
+}
+
+/**
+ * Whether the process was asked to stop since catchInterrupts().
+ */
+bool Surface::isInterrupted() { return interrupted != 0; }
+
+/**
+ * Reads back the currently bound framebuffer and writes it as a binary PPM image.
+ * Offscreen surfaces keep their contents after display(); for windows, call it before.
+ * @param path The file to write.
+ * @return True on success.
+ */
+bool Surface::saveFrame(const std::string& path) const
+{
+  auto [width, height]{getSize()};
+  std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+  return writePPM(path, width, height, pixels.data(), true);
+}
+
+/**
+ * Creates the surface for the backend the options select, with an OpenGL 4.4 core context,
+ * and makes the context current.
+ * @param options The launch options.
+ * @param size The framebuffer dimensions (width, height).
+ * @param title Window title.
+ * @param share A surface made by an earlier call with the same options, whose context shares
+ * its objects with the new one; nullptr for a context of its own. SFML already puts every
+ * window's context in one share group, so only offscreen surfaces need it.
+ * @return The surface, or nullptr when rendering on the CPU or to a terminal.
+ */
+std::unique_ptr<Surface> Surface::create(const LaunchOptions& options, const ScreenSize& size, const std::string& title,
+                                         [[maybe_unused]] const Surface* share)
+{
+  if (options.backend == Backend::Headless)
+  {
+#ifdef SNAKE_HEADLESS
+    return std::make_unique<HeadlessSurface>(size, static_cast<const HeadlessSurface*>(share));
+#endif
+  }
+  else if (options.backend == Backend::Window)
+  {
+    sf::ContextSettings settings;
+    settings.depthBits = 24;
+    settings.stencilBits = 8;
+    settings.majorVersion = 4;
+    settings.minorVersion = 4;
+    settings.attributeFlags = sf::ContextSettings::Core;
+
+    return std::make_unique<WindowSurface>(size, title, settings);
+  }
+
+  return nullptr;
+}
+
+WindowSurface::WindowSurface(const ScreenSize& size, const std::string& title, const sf::ContextSettings& settings)
+{
+  sf::VideoMode desktopMode{sf::VideoMode::getDesktopMode()};
+  desktopMode.size.x = size.first;
+  desktopMode.size.y = size.second;
+
+  window.create(desktopMode, title, sf::Style::Default, sf::State::Windowed, settings);
+  window.setFramerateLimit(60);
+
+  if (!gladLoadGL())
+  {
+    throw std::runtime_error("Failed to initialize GLAD");
+  }
+  GLProfiler::install();
+}
+
+GLADloadproc WindowSurface::getLoader() const
+{
+  return [](const char* name) { return reinterpret_cast<void*>(sf::Context::getFunction(name)); };
+}
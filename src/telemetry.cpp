@@ -0,0 +1,469 @@
+#include "../include/telemetry.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "../include/checksum.hpp"
+
+namespace
+{
+constexpr size_t Alignment{32};  // of every column array, for aligned vector loads
+
+// File header, followed by one ColumnDescriptor per column, then the blocks
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t columnCount;
+  uint32_t reserved[4];
+};
+
+struct ColumnDescriptor
+{
+  char name[24];
+  uint32_t type;
+  uint32_t reserved;
+};
+
+// Starts every block; the payload after it is the ColumnStats, then the column arrays
+struct BlockHeader
+{
+  char magic[4];
+  uint32_t rows;
+  uint64_t payloadSize;
+  uint32_t checksum;  // CRC-32 of the payload
+  uint32_t columnCount;
+  uint64_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 32 && sizeof(ColumnDescriptor) == 32 && sizeof(BlockHeader) == 32,
+              "headers keep the column arrays aligned");
+
+constexpr char FileMagic[8]{'S', 'N', 'A', 'K', 'E', 'T', 'E', 'L'};
+constexpr char BlockMagic[4]{'B', 'L', 'K', '\0'};
+constexpr uint32_t Version{1};
+
+constexpr size_t headerSize(size_t columns) { return sizeof(FileHeader) + columns * sizeof(ColumnDescriptor); }
+
+constexpr size_t alignUp(size_t size) { return (size + Alignment - 1) / Alignment * Alignment; }
+
+constexpr size_t statsSize(size_t columns) { return alignUp(columns * sizeof(ColumnStats)); }
+
+/**
+ * Copies one field of every record into a column array and returns its min and max.
+ */
+template <typename T, typename Field>
+void fillColumn(const GameRecord* records, size_t count, Field field, unsigned char* out, ColumnStats& stats)
+{
+  T* values{reinterpret_cast<T*>(out)};
+  T min{records[0].*field}, max{min};
+  for (size_t i{0}; i < count; ++i)
+  {
+    const T value{records[i].*field};
+    values[i] = value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  stats.min = static_cast<double>(min);
+  stats.max = static_cast<double>(max);
+}
+}  // namespace
+
+/**
+ * Bytes per value of a column type.
+ */
+size_t columnTypeSize(ColumnType type)
+{
+  switch (type)
+  {
+    case ColumnU8:
+      return 1;
+    case ColumnU16:
+      return 2;
+    case ColumnU32:
+    case ColumnF32:
+      return 4;
+    case ColumnU64:
+      return 8;
+  }
+  return 0;
+}
+
+TelemetryWriter::~TelemetryWriter() { close(); }
+
+/**
+ * Opens a telemetry file for appending, creating it and its directory if needed.
+ * A block left incomplete or damaged at the end by a crash is cut off first.
+ * @param file Path of the file.
+ * @return Whether games can be added. A file that isn't telemetry, or has other columns, is left alone.
+ */
+bool TelemetryWriter::open(const std::string& file)
+{
+  close();
+  if (!openFile(file)) return false;
+
+  closing = false;
+  flusher = std::thread(&TelemetryWriter::run, this);
+  return true;
+}
+
+/**
+ * Opens the file and checks or writes its header, see open().
+ */
+bool TelemetryWriter::openFile(const std::string& file)
+{
+  path = file;
+
+  std::error_code error;
+  const std::filesystem::path parent{std::filesystem::path(path).parent_path()};
+  if (!parent.empty()) std::filesystem::create_directories(parent, error);
+
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Telemetry: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  // The header this build writes
+  std::vector<unsigned char> header(headerSize(TelemetryColumnCount));
+  FileHeader fileHeader{};
+  std::memcpy(fileHeader.magic, FileMagic, sizeof(FileMagic));
+  fileHeader.version = Version;
+  fileHeader.columnCount = TelemetryColumnCount;
+  std::memcpy(header.data(), &fileHeader, sizeof(fileHeader));
+  for (size_t i{0}; i < TelemetryColumnCount; ++i)
+  {
+    ColumnDescriptor descriptor{};
+    std::strncpy(descriptor.name, TelemetryColumns[i].name, sizeof(descriptor.name) - 1);
+    descriptor.type = TelemetryColumns[i].type;
+    std::memcpy(header.data() + sizeof(FileHeader) + i * sizeof(ColumnDescriptor), &descriptor, sizeof(descriptor));
+  }
+
+  struct stat info{};
+  fstat(fd, &info);
+
+  // Only a new, empty file gets a header; anything else must already be telemetry
+  if (info.st_size == 0)
+  {
+    if (write(fd, header.data(), header.size()) != static_cast<ssize_t>(header.size()) || fsync(fd) != 0)
+    {
+      std::cerr << "Telemetry: cannot write " << path << ": " << std::strerror(errno) << std::endl;
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<unsigned char> existing(header.size());
+  if (pread(fd, existing.data(), existing.size(), 0) != static_cast<ssize_t>(existing.size()) || existing != header)
+  {
+    std::cerr << "Telemetry: " << path << " is not a telemetry file with these columns, not touching it" << std::endl;
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+
+  // Walk the block headers to the end; only the last block can have been torn, so only it is checksummed
+  const off_t size{info.st_size};
+  off_t offset{static_cast<off_t>(header.size())}, last{-1};
+  BlockHeader blockHeader{};
+  while (offset + static_cast<off_t>(sizeof(BlockHeader)) <= size &&
+         pread(fd, &blockHeader, sizeof(blockHeader), offset) == sizeof(blockHeader) &&
+         std::memcmp(blockHeader.magic, BlockMagic, sizeof(BlockMagic)) == 0 &&
+         blockHeader.payloadSize <= static_cast<uint64_t>(size - offset) - sizeof(BlockHeader))
+  {
+    last = offset;
+    offset += static_cast<off_t>(sizeof(BlockHeader) + blockHeader.payloadSize);
+  }
+  if (last >= 0)
+  {
+    pread(fd, &blockHeader, sizeof(blockHeader), last);
+    block.resize(blockHeader.payloadSize);
+    if (pread(fd, block.data(), block.size(), last + static_cast<off_t>(sizeof(BlockHeader))) !=
+            static_cast<ssize_t>(block.size()) ||
+        crc32(block.data(), block.size()) != blockHeader.checksum)
+    {
+      offset = last;
+    }
+  }
+
+  if (offset < size)
+  {
+    std::cerr << "Telemetry: dropping " << size - offset << " damaged bytes at the end of " << path << std::endl;
+    if (ftruncate(fd, offset) != 0)
+    {
+      std::cerr << "Telemetry: cannot repair " << path << ": " << std::strerror(errno) << std::endl;
+    }
+  }
+  return true;
+}
+
+/**
+ * Queues a finished game, for the flusher thread to write.
+ * @param record The game.
+ */
+void TelemetryWriter::add(const GameRecord& record)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (fd < 0) return;
+
+  if (pending.empty()) firstPending = std::chrono::steady_clock::now();
+  pending.push_back(record);
+
+  // The flusher thread only needs waking for a first game to time, or a full block
+  if (pending.size() == 1 || pending.size() == BlockRows) wake.notify_one();
+}
+
+/**
+ * Flusher thread: writes the queued games once they fill a block or the oldest has waited
+ * FlushInterval, so a crash loses at most that much. Runs until close().
+ */
+void TelemetryWriter::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!closing)
+  {
+    const auto due{firstPending + FlushInterval};
+    if (pending.size() >= BlockRows || (!pending.empty() && std::chrono::steady_clock::now() >= due))
+    {
+      lock.unlock();
+      flush();
+      lock.lock();
+    }
+    else if (pending.empty())
+    {
+      wake.wait(lock);
+    }
+    else
+    {
+      wake.wait_until(lock, due);
+    }
+  }
+}
+
+/**
+ * Games queued for the next block.
+ */
+size_t TelemetryWriter::getPending()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return pending.size();
+}
+
+/**
+ * Writes out the queued games, however few.
+ */
+void TelemetryWriter::flush()
+{
+  std::lock_guard<std::mutex> writing(writeMutex);
+  while (writeBlock())
+  {
+  }
+}
+
+/**
+ * Writes up to BlockRows queued games as one block, column by column. The games are taken
+ * under the mutex and written without it, so add() never waits for the disk. Called with
+ * writeMutex held, which guards the block buffer.
+ * @return Whether there were games to write.
+ */
+bool TelemetryWriter::writeBlock()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  if (fd < 0 || pending.empty()) return false;
+
+  const size_t rows{std::min<size_t>(pending.size(), BlockRows)};
+  size_t payload{statsSize(TelemetryColumnCount)};
+  ColumnStats stats[TelemetryColumnCount]{};
+  for (size_t i{0}; i < TelemetryColumnCount; ++i)
+  {
+    stats[i].offset = payload;
+    payload += alignUp(rows * columnTypeSize(TelemetryColumns[i].type));
+  }
+
+  block.assign(sizeof(BlockHeader) + payload, 0);
+  unsigned char* data{block.data() + sizeof(BlockHeader)};
+  const auto column{[&](size_t i) { return data + stats[i].offset; }};
+
+  const GameRecord* records{pending.data()};
+  fillColumn<uint64_t>(records, rows, &GameRecord::endTime, column(0), stats[0]);
+  fillColumn<uint32_t>(records, rows, &GameRecord::seed, column(1), stats[1]);
+  fillColumn<uint8_t>(records, rows, &GameRecord::agent, column(2), stats[2]);
+  fillColumn<uint16_t>(records, rows, &GameRecord::gridWidth, column(3), stats[3]);
+  fillColumn<uint16_t>(records, rows, &GameRecord::gridHeight, column(4), stats[4]);
+  fillColumn<uint8_t>(records, rows, &GameRecord::difficulty, column(5), stats[5]);
+  fillColumn<float>(records, rows, &GameRecord::moveDelay, column(6), stats[6]);
+  fillColumn<uint32_t>(records, rows, &GameRecord::length, column(7), stats[7]);
+  fillColumn<uint32_t>(records, rows, &GameRecord::score, column(8), stats[8]);
+  fillColumn<uint32_t>(records, rows, &GameRecord::ticks, column(9), stats[9]);
+  fillColumn<uint8_t>(records, rows, &GameRecord::deathCause, column(10), stats[10]);
+  fillColumn<uint32_t>(records, rows, &GameRecord::bigFoodHits, column(11), stats[11]);
+  fillColumn<uint32_t>(records, rows, &GameRecord::bigFoodMisses, column(12), stats[12]);
+  static_assert(TelemetryColumnCount == 13, "every column is filled above");
+  std::memcpy(data, stats, sizeof(stats));
+  pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(rows));
+  const int file{fd};
+  lock.unlock();
+
+  BlockHeader header{};
+  std::memcpy(header.magic, BlockMagic, sizeof(BlockMagic));
+  header.rows = static_cast<uint32_t>(rows);
+  header.payloadSize = payload;
+  header.checksum = crc32(data, payload);
+  header.columnCount = TelemetryColumnCount;
+  std::memcpy(block.data(), &header, sizeof(header));
+
+  // One write per block: a crash leaves at most this block torn, which the next open() cuts off
+  if (write(file, block.data(), block.size()) != static_cast<ssize_t>(block.size()))
+  {
+    std::cerr << "Telemetry: cannot append to " << path << ": " << std::strerror(errno) << std::endl;
+  }
+  else
+  {
+    fdatasync(file);
+  }
+  return true;
+}
+
+/**
+ * Stops the flusher thread, writes out the queued games and closes the file.
+ */
+void TelemetryWriter::close()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closing = true;
+  }
+  wake.notify_one();
+  if (flusher.joinable()) flusher.join();
+
+  flush();
+
+  std::lock_guard<std::mutex> writing(writeMutex);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (fd < 0) return;
+  ::close(fd);
+  fd = -1;
+}
+
+TelemetryFile::~TelemetryFile()
+{
+  if (mapped) munmap(mapped, mappedSize);
+}
+
+/**
+ * Maps a telemetry file and indexes its blocks. Reading stops at a block cut short.
+ * @param path Path of the file.
+ * @param verify Also checksum every block, skipping damaged ones; otherwise only the structure is checked.
+ * @return Whether the file is telemetry.
+ */
+bool TelemetryFile::open(const std::string& path, bool verify)
+{
+  const int fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (fd < 0)
+  {
+    std::cerr << "Telemetry: cannot open " << path << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  struct stat info{};
+  fstat(fd, &info);
+  mappedSize = static_cast<size_t>(info.st_size);
+  mapped = mappedSize >= sizeof(FileHeader) ? mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+  ::close(fd);
+  if (mapped == MAP_FAILED || !mapped)
+  {
+    mapped = nullptr;
+    std::cerr << "Telemetry: cannot map " << path << std::endl;
+    return false;
+  }
+  madvise(mapped, mappedSize, MADV_SEQUENTIAL);
+
+  const auto* bytes{static_cast<const unsigned char*>(mapped)};
+  FileHeader fileHeader;
+  std::memcpy(&fileHeader, bytes, sizeof(fileHeader));
+  if (std::memcmp(fileHeader.magic, FileMagic, sizeof(FileMagic)) != 0 || fileHeader.version != Version ||
+      mappedSize < headerSize(fileHeader.columnCount))
+  {
+    std::cerr << "Telemetry: " << path << " is not a telemetry file" << std::endl;
+    return false;
+  }
+
+  for (size_t i{0}; i < fileHeader.columnCount; ++i)
+  {
+    ColumnDescriptor descriptor;
+    std::memcpy(&descriptor, bytes + sizeof(FileHeader) + i * sizeof(ColumnDescriptor), sizeof(descriptor));
+    if (descriptor.type > ColumnF32)
+    {
+      std::cerr << "Telemetry: " << path << " has a column of unknown type" << std::endl;
+      columns.clear();
+      return false;
+    }
+    columns.push_back({std::string(descriptor.name, strnlen(descriptor.name, sizeof(descriptor.name))),
+                       static_cast<ColumnType>(descriptor.type)});
+  }
+
+  // Queries read straight from the offsets, so they are checked even without verify: the stats and
+  // every column array must lie inside the payload, aligned for vector loads
+  const auto fitsPayload{[this](const BlockHeader& header, const unsigned char* data)
+                         {
+                           if (header.payloadSize < statsSize(columns.size())) return false;
+                           for (size_t i{0}; i < columns.size(); ++i)
+                           {
+                             ColumnStats stats;
+                             std::memcpy(&stats, data + i * sizeof(ColumnStats), sizeof(stats));
+                             const uint64_t arraySize{
+                                 alignUp(static_cast<size_t>(header.rows) * columnTypeSize(columns[i].type))};
+                             if (stats.offset % Alignment != 0 || stats.offset > header.payloadSize ||
+                                 arraySize > header.payloadSize - stats.offset)
+                             {
+                               return false;
+                             }
+                           }
+                           return true;
+                         }};
+
+  size_t offset{headerSize(columns.size())};
+  while (offset + sizeof(BlockHeader) <= mappedSize)
+  {
+    BlockHeader header;
+    std::memcpy(&header, bytes + offset, sizeof(header));
+    if (std::memcmp(header.magic, BlockMagic, sizeof(BlockMagic)) != 0 || header.columnCount != columns.size() ||
+        header.payloadSize > mappedSize - offset - sizeof(BlockHeader))
+    {
+      break;
+    }
+
+    const unsigned char* data{bytes + offset + sizeof(BlockHeader)};
+    offset += sizeof(BlockHeader) + header.payloadSize;
+    if (!fitsPayload(header, data) || (verify && crc32(data, header.payloadSize) != header.checksum))
+    {
+      ++damaged;
+      continue;
+    }
+
+    blocks.push_back({header.rows, reinterpret_cast<const ColumnStats*>(data), data});
+    rows += header.rows;
+  }
+  return true;
+}
+
+/**
+ * Index of a column by name, -1 if the file has none.
+ */
+int TelemetryFile::findColumn(const std::string& name) const
+{
+  for (size_t i{0}; i < columns.size(); ++i)
+  {
+    if (columns[i].name == name) return static_cast<int>(i);
+  }
+  return -1;
+}
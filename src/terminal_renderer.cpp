@@ -0,0 +1,395 @@
+#include "../include/terminal_renderer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Same color as RenderEngine::clearScreen and the software renderer
+static constexpr uint32_t BackgroundColor{0x334C4C};
+
+// Set on SIGWINCH: the terminal was resized and may have scrolled or reflowed what it showed
+static volatile std::sig_atomic_t resized{0};
+
+static void onResize(int) { resized = 1; }
+
+/**
+ * Average color of a sprite's opaque texels, as 0xRRGGBB.
+ */
+static uint32_t spriteColor(GLuint sprite)
+{
+  const std::vector<uint32_t>& atlas{SpriteAtlas::getPixels()};
+  const GLuint x0{(sprite % SpriteAtlas::Columns) * SpriteAtlas::SpriteSize};
+  const GLuint y0{(sprite / SpriteAtlas::Columns) * SpriteAtlas::SpriteSize};
+
+  uint32_t sums[3]{}, count{0};
+  for (GLuint y{y0}; y < y0 + SpriteAtlas::SpriteSize; ++y)
+  {
+    for (GLuint x{x0}; x < x0 + SpriteAtlas::SpriteSize; ++x)
+    {
+      unsigned char texel[4];
+      std::memcpy(texel, &atlas[y * SpriteAtlas::Size + x], sizeof(texel));
+      if (texel[3] < 128) continue;
+      for (int channel{0}; channel < 3; ++channel) sums[channel] += texel[channel];
+      ++count;
+    }
+  }
+  if (count == 0) return BackgroundColor;
+
+  return (sums[0] / count) << 16 | (sums[1] / count) << 8 | sums[2] / count;
+}
+
+/**
+ * Takes over the terminal: alternate screen, hidden cursor, and unbuffered input without echo
+ * when stdin is a terminal. All of it is undone by the destructor.
+ * @param gridInfo Grid the scene is laid out on; its cells are the board's.
+ * @param fd Where the frames go, -1 to only build them (see getOutput()).
+ */
+TerminalRenderer::TerminalRenderer(const GridInfo& gridInfo, int fd) : gridInfo(gridInfo), fd(fd)
+{
+  const auto [xMax, yMax]{gridInfo.getGridSizeI()};
+  columns = xMax;
+  rows = (yMax + 1) / 2;
+  cells.resize(static_cast<size_t>(columns) * rows * 2);
+  shown.resize(static_cast<size_t>(columns) * rows);
+
+  for (GLuint sprite{0}; sprite < spriteColors.size(); ++sprite) spriteColors[sprite] = spriteColor(sprite);
+
+  // Room for a full repaint, so frames never grow the buffer: a move, two SGRs and a character each
+  output.reserve(shown.size() * 64 + 256);
+
+  if (fd < 0) return;
+
+  // Keys arrive one at a time without Enter and without being echoed; ^C still interrupts
+  if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &savedMode) == 0)
+  {
+    termios mode{savedMode};
+    mode.c_lflag &= ~(ICANON | ECHO);
+    mode.c_cc[VMIN] = 0;
+    mode.c_cc[VTIME] = 0;
+    rawInput = tcsetattr(STDIN_FILENO, TCSANOW, &mode) == 0;
+  }
+  std::signal(SIGWINCH, onResize);
+
+  write("\x1b[?1049h\x1b[?25l");
+}
+
+TerminalRenderer::~TerminalRenderer()
+{
+  if (fd < 0) return;
+
+  std::signal(SIGWINCH, SIG_DFL);
+  write("\x1b[0m\x1b[?25h\x1b[?1049l");
+  if (rawInput) tcsetattr(STDIN_FILENO, TCSANOW, &savedMode);
+}
+
+/**
+ * Board size that fills the terminal, in cells: two per character row, less the status line.
+ * Falls back to 80x24 characters when fd is not a terminal.
+ */
+ScreenSize TerminalRenderer::getBoardSize(int fd)
+{
+  winsize size{};
+  if (ioctl(fd, TIOCGWINSZ, &size) != 0 || size.ws_col == 0 || size.ws_row == 0)
+  {
+    size.ws_col = 80;
+    size.ws_row = 24;
+  }
+
+  return {std::max<GLuint>(size.ws_col, MinColumns), std::max<GLuint>((size.ws_row - 1) * 2, MinRows)};
+}
+
+/**
+ * Forgets what the terminal shows, so the next frame clears it and draws everything.
+ */
+void TerminalRenderer::invalidate()
+{
+  std::fill(shown.begin(), shown.end(), ~uint64_t{0});
+  statusShown = false;
+  clearScreen = true;
+}
+
+/**
+ * Draws a frame, writing only what changed since the last one.
+ * @param snapshot The state to draw.
+ * @param status Text for the status line, ASCII; cut to the board's width.
+ */
+void TerminalRenderer::render(const GameSnapshot& snapshot, std::string_view status)
+{
+  if (resized)
+  {
+    resized = 0;
+    invalidate();
+  }
+
+  // Same order as the render queue: items, then the snake on top
+  std::fill(cells.begin(), cells.end(), BackgroundColor);
+  for (const auto& cell : snapshot.items) paint(cell);
+  for (const auto& cell : snapshot.snake) paint(cell);
+
+  output.clear();
+  if (clearScreen)
+  {
+    output += "\x1b[0m\x1b[2J";
+    cursorRow = cursorColumn = Unknown;
+    foreground = background = Unknown;
+    clearScreen = false;
+  }
+
+  for (GLuint row{0}; row < rows; ++row)
+  {
+    const uint32_t* top{&cells[static_cast<size_t>(row) * 2 * columns]};
+    const uint32_t* bottom{top + columns};
+    uint64_t* onScreen{&shown[static_cast<size_t>(row) * columns]};
+    for (GLuint column{0}; column < columns; ++column)
+    {
+      const uint64_t pair{static_cast<uint64_t>(top[column]) << 32 | bottom[column]};
+      if (onScreen[column] == pair) continue;
+      drawCharacter(row, column, top[column], bottom[column]);
+      onScreen[column] = pair;
+    }
+  }
+
+  status = status.substr(0, columns);
+  if (!statusShown || status != shownStatus) drawStatus(status);
+
+  write(output);
+}
+
+/**
+ * Fills the cell a snapshot cell stands on with its sprite's color. Cell 0 of each axis is
+ * the wraparound row and column, off screen like in the window.
+ */
+void TerminalRenderer::paint(const CellInstance& cell)
+{
+  const long column{std::lround(cell.x) - 1}, row{std::lround(cell.y) - 1};
+  if (column < 0 || row < 0 || column >= static_cast<long>(columns) || row >= static_cast<long>(rows * 2)) return;
+
+  cells[static_cast<size_t>(row) * columns + column] = spriteColors[cell.sprite % spriteColors.size()];
+}
+
+/**
+ * Writes one character showing two cells, with whichever of '▀', '▄', '█' or a space needs
+ * the fewest colors changed.
+ */
+void TerminalRenderer::drawCharacter(GLuint row, GLuint column, uint32_t top, uint32_t bottom)
+{
+  moveTo(row, column);
+
+  if (top == bottom)
+  {
+    if (top == foreground && top != background)
+    {
+      output += "█";
+    }
+    else
+    {
+      setColors(Unknown, top);
+      output += ' ';
+    }
+  }
+  else if ((bottom != foreground) + (top != background) < (top != foreground) + (bottom != background))
+  {
+    setColors(bottom, top);
+    output += "▄";
+  }
+  else
+  {
+    setColors(top, bottom);
+    output += "▀";
+  }
+
+  // Past the last column the cursor waits to wrap, where terminals disagree
+  cursorColumn = column + 1 < columns ? column + 1 : Unknown;
+}
+
+/**
+ * Rewrites the status line below the board, in the terminal's default colors.
+ */
+void TerminalRenderer::drawStatus(std::string_view status)
+{
+  moveTo(rows, 0);
+  output += "\x1b[0m";
+  output += status;
+  output += "\x1b[K";
+
+  foreground = background = Unknown;
+  cursorColumn = Unknown;
+  shownStatus.assign(status.data(), status.size());
+  statusShown = true;
+}
+
+/**
+ * Puts the cursor on a character: nothing when it is already there, a move to the right
+ * along the same row, else an absolute position.
+ */
+void TerminalRenderer::moveTo(GLuint row, GLuint column)
+{
+  if (row == cursorRow && column == cursorColumn) return;
+
+  if (row == cursorRow && cursorColumn != Unknown && column > cursorColumn)
+  {
+    output += "\x1b[";
+    if (column - cursorColumn > 1) appendNumber(column - cursorColumn);
+    output += 'C';
+  }
+  else
+  {
+    output += "\x1b[";
+    appendNumber(row + 1);
+    output += ';';
+    appendNumber(column + 1);
+    output += 'H';
+  }
+  cursorRow = row;
+  cursorColumn = column;
+}
+
+/**
+ * Sets the colors the next character is written in, in a single SGR sequence.
+ * @param foreground 0xRRGGBB, or Unknown to leave it as it is.
+ * @param background 0xRRGGBB.
+ */
+void TerminalRenderer::setColors(uint32_t foreground, uint32_t background)
+{
+  const bool newForeground{foreground != Unknown && foreground != this->foreground};
+  const bool newBackground{background != this->background};
+  if (!newForeground && !newBackground) return;
+
+  output += "\x1b[";
+  if (newForeground)
+  {
+    output += "38;2;";
+    appendColor(foreground);
+    this->foreground = foreground;
+  }
+  if (newBackground)
+  {
+    output += newForeground ? ";48;2;" : "48;2;";
+    appendColor(background);
+    this->background = background;
+  }
+  output += 'm';
+}
+
+/**
+ * Appends 0xRRGGBB as the "R;G;B" of an SGR color.
+ */
+void TerminalRenderer::appendColor(uint32_t color)
+{
+  appendNumber(color >> 16);
+  output += ';';
+  appendNumber(color >> 8 & 0xFF);
+  output += ';';
+  appendNumber(color & 0xFF);
+}
+
+void TerminalRenderer::appendNumber(uint32_t value)
+{
+  char digits[10];
+  const auto [end, error]{std::to_chars(digits, digits + sizeof(digits), value)};
+  output.append(digits, end);
+}
+
+/**
+ * Writes all of bytes to the terminal, however many write() calls it takes.
+ */
+void TerminalRenderer::write(std::string_view bytes) const
+{
+  if (fd < 0) return;
+
+  while (!bytes.empty())
+  {
+    const ssize_t written{::write(fd, bytes.data(), bytes.size())};
+    if (written < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      return;
+    }
+    bytes.remove_prefix(static_cast<size_t>(written));
+  }
+}
+
+/**
+ * Reads the next key pressed, if any, without blocking. Arrow keys come as escape sequences;
+ * an Esc on its own pauses, like in the window.
+ */
+TerminalKey TerminalRenderer::readKey()
+{
+  if (!rawInput) return KeyNone;
+
+  char key;
+  if (read(STDIN_FILENO, &key, 1) != 1) return KeyNone;
+
+  if (key == '\x1b')
+  {
+    // ESC [ A or, in application cursor mode, ESC O A; the sequence arrives in one piece
+    char sequence[2];
+    if (read(STDIN_FILENO, &sequence[0], 1) != 1) return KeyPause;
+    if ((sequence[0] != '[' && sequence[0] != 'O') || read(STDIN_FILENO, &sequence[1], 1) != 1) return KeyNone;
+    key = sequence[1];
+    switch (key)
+    {
+      case 'A':
+        return KeyUp;
+      case 'B':
+        return KeyDown;
+      case 'C':
+        return KeyRight;
+      case 'D':
+        return KeyLeft;
+      default:
+        return KeyNone;
+    }
+  }
+
+  switch (key)
+  {
+    case 'w':
+    case 'W':
+      return KeyUp;
+    case 's':
+    case 'S':
+      return KeyDown;
+    case 'a':
+    case 'A':
+      return KeyLeft;
+    case 'd':
+    case 'D':
+      return KeyRight;
+    case ' ':
+    case 'p':
+    case 'P':
+      return KeyPause;
+    case 'r':
+    case 'R':
+      return KeyReset;
+    case 'q':
+    case 'Q':
+      return KeyQuit;
+    default:
+      return KeyNone;
+  }
+}
+
+/**
+ * Sleeps until a key is pressed or the timeout passes.
+ * @param timeoutMs Longest wait, in milliseconds.
+ */
+void TerminalRenderer::waitInput(int timeoutMs) const
+{
+  // Without a terminal to read, stdin may be at EOF and always readable
+  if (!rawInput)
+  {
+    poll(nullptr, 0, timeoutMs);
+    return;
+  }
+
+  pollfd input{STDIN_FILENO, POLLIN, 0};
+  poll(&input, 1, timeoutMs);
+}
@@ -0,0 +1,113 @@
+#include "../include/timing_histogram.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+/**
+ * Bucket a duration is counted in. Below SubBuckets nanoseconds every value has its own bucket;
+ * above, the top SubBucketBits bits after the leading one pick the bucket within its power of two.
+ */
+size_t TimingHistogram::bucketOf(uint64_t nanoseconds)
+{
+  if (nanoseconds < SubBuckets) return static_cast<size_t>(nanoseconds);
+
+  const unsigned msb{63u - static_cast<unsigned>(__builtin_clzll(nanoseconds))};
+  if (msb >= MaxBits) return BucketCount - 1;
+
+  const unsigned shift{msb - SubBucketBits};
+  return static_cast<size_t>((shift + 1) * SubBuckets + ((nanoseconds >> shift) & (SubBuckets - 1)));
+}
+
+/**
+ * Largest duration counted in a bucket, in nanoseconds.
+ */
+uint64_t TimingHistogram::bucketTop(size_t bucket)
+{
+  const uint64_t group{bucket / SubBuckets}, sub{bucket % SubBuckets};
+  if (group == 0) return sub;
+
+  const uint64_t width{uint64_t{1} << (group - 1)};
+  return (SubBuckets + sub) * width + width - 1;
+}
+
+/**
+ * Counts one duration. Lock-free, any thread.
+ * @param duration The duration.
+ */
+void TimingHistogram::record(std::chrono::nanoseconds duration)
+{
+  const uint64_t nanoseconds{static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0))};
+
+  buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  count.fetch_add(1, std::memory_order_relaxed);
+  total.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+  uint64_t largestSoFar{largest.load(std::memory_order_relaxed)};
+  while (nanoseconds > largestSoFar &&
+         !largest.compare_exchange_weak(largestSoFar, nanoseconds, std::memory_order_relaxed))
+  {
+  }
+}
+
+/**
+ * Count, mean and percentiles so far. Percentiles are the top of the bucket they fall in,
+ * so they never understate a hitch. Safe while another thread records; the result is then
+ * a little behind.
+ */
+TimingHistogram::Summary TimingHistogram::summarize() const
+{
+  Summary summary;
+
+  // One pass over the buckets, so the percentiles agree with each other
+  std::array<uint64_t, BucketCount> counts;
+  for (size_t i{0}; i < BucketCount; ++i)
+  {
+    counts[i] = buckets[i].load(std::memory_order_relaxed);
+    summary.count += counts[i];
+  }
+  if (summary.count == 0) return summary;
+
+  const uint64_t largestSeen{largest.load(std::memory_order_relaxed)};
+  const double toMs{1e-6};
+  summary.mean = static_cast<double>(total.load(std::memory_order_relaxed)) / std::max<uint64_t>(getCount(), 1) * toMs;
+  summary.max = largestSeen * toMs;
+
+  const std::pair<double, double Summary::*> percentiles[]{
+      {0.5, &Summary::p50}, {0.99, &Summary::p99}, {0.999, &Summary::p999}};
+  uint64_t seen{0};
+  size_t bucket{0};
+  for (const auto& [fraction, field] : percentiles)
+  {
+    // The smallest bucket with at least that fraction of the samples at or below it
+    const uint64_t rank{std::max<uint64_t>(1, static_cast<uint64_t>(fraction * summary.count + 0.5))};
+    while (seen + counts[bucket] < rank) seen += counts[bucket++];
+    summary.*field = std::min(bucketTop(bucket), largestSeen) * toMs;
+  }
+  return summary;
+}
+
+/**
+ * Prints a table of histograms' summaries, skipping empty ones.
+ * @param out Where to print.
+ * @param title First line.
+ * @param histograms Name and histogram of each row; null ones are skipped too.
+ */
+void TimingHistogram::report(std::ostream& out, const char* title,
+                             std::initializer_list<std::pair<const char*, const TimingHistogram*>> histograms)
+{
+  char line[128];
+  out << title << " (ms):\n";
+  std::snprintf(line, sizeof(line), "  %-14s %9s %8s %8s %8s %8s %8s\n", "", "count", "mean", "p50", "p99", "p99.9",
+                "max");
+  out << line;
+
+  for (const auto& [name, histogram] : histograms)
+  {
+    if (!histogram) continue;
+    const Summary s{histogram->summarize()};
+    if (s.count == 0) continue;
+    std::snprintf(line, sizeof(line), "  %-14s %9llu %8.2f %8.2f %8.2f %8.2f %8.2f\n", name,
+                  static_cast<unsigned long long>(s.count), s.mean, s.p50, s.p99, s.p999, s.max);
+    out << line;
+  }
+}
@@ -0,0 +1,154 @@
+#include "../include/trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Trace::enabled{false};
+
+namespace
+{
+struct TraceEvent
+{
+  const char* name;
+  uint64_t start, end;  // nanoseconds since the trace started
+};
+
+// One thread's events, in fixed-size chunks so recording never moves what is already there
+struct ThreadBuffer
+{
+  static constexpr size_t ChunkSize{4096};
+
+  unsigned tid;
+  std::string name;
+  std::vector<std::unique_ptr<std::vector<TraceEvent>>> chunks;
+
+  void push(const TraceEvent& event)
+  {
+    if (chunks.empty() || chunks.back()->size() == ChunkSize)
+    {
+      chunks.push_back(std::make_unique<std::vector<TraceEvent>>());
+      chunks.back()->reserve(ChunkSize);
+    }
+    chunks.back()->push_back(event);
+  }
+};
+
+// Buffers outlive their threads, so a worker that has exited still shows up in the trace
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+std::chrono::steady_clock::time_point origin{std::chrono::steady_clock::now()};
+
+thread_local ThreadBuffer* threadBuffer{nullptr};
+
+/**
+ * The calling thread's buffer, registered on first use.
+ */
+ThreadBuffer& getThreadBuffer()
+{
+  if (!threadBuffer)
+  {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back(std::make_unique<ThreadBuffer>());
+    threadBuffer = registry.back().get();
+    threadBuffer->tid = static_cast<unsigned>(registry.size());
+  }
+  return *threadBuffer;
+}
+
+/**
+ * Escapes a name for a JSON string.
+ */
+std::string escape(const char* text)
+{
+  std::string escaped;
+  for (const char* c{text}; *c; ++c)
+  {
+    if (*c == '"' || *c == '\\') escaped += '\\';
+    escaped += *c;
+  }
+  return escaped;
+}
+}  // namespace
+
+/**
+ * Starts recording scopes on every thread.
+ */
+void Trace::start()
+{
+  origin = std::chrono::steady_clock::now();
+  enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Names the calling thread in the trace, e.g. "render" or "simulation".
+ * @param name The thread name.
+ */
+void Trace::nameThread(const char* name) { getThreadBuffer().name = name; }
+
+/**
+ * Nanoseconds since the trace started.
+ */
+uint64_t Trace::now()
+{
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count());
+}
+
+/**
+ * Adds a finished scope to the calling thread's buffer.
+ * @param name Scope name; must outlive the trace, e.g. a string literal.
+ * @param start Scope start, from now().
+ * @param end Scope end, from now().
+ */
+void Trace::record(const char* name, uint64_t start, uint64_t end) { getThreadBuffer().push({name, start, end}); }
+
+/**
+ * Stops recording and writes every thread's scopes as Chrome trace JSON ("X" complete events,
+ * in microseconds). Threads that record scopes must have stopped by now.
+ * @param path The file to write.
+ * @return Whether the file was written.
+ */
+bool Trace::write(const std::string& path)
+{
+  enabled.store(false, std::memory_order_relaxed);
+
+  std::ofstream file(path);
+  if (!file) return false;
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+  bool first{true};
+  char line[256];
+  for (const auto& buffer : registry)
+  {
+    if (!buffer->name.empty())
+    {
+      std::snprintf(line, sizeof(line),
+                    "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                    first ? "" : ",\n", buffer->tid, escape(buffer->name.c_str()).c_str());
+      file << line;
+      first = false;
+    }
+
+    for (const auto& chunk : buffer->chunks)
+    {
+      for (const TraceEvent& event : *chunk)
+      {
+        std::snprintf(line, sizeof(line),
+                      "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                      first ? "" : ",\n", escape(event.name).c_str(), buffer->tid, event.start / 1000.0,
+                      (event.end - event.start) / 1000.0);
+        file << line;
+        first = false;
+      }
+    }
+  }
+
+  file << "\n]}\n";
+  return static_cast<bool>(file);
+}
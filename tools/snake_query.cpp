@@ -0,0 +1,390 @@
+// Aggregates a telemetry file (see include/telemetry.hpp) without loading it.
+//
+// The file is mapped and scanned block by block. A --where filter first rules out whole blocks
+// from their min/max, then builds a row mask over the column it tests; the requested columns are
+// summed, and their min and max taken, under that mask. 32-bit columns go through SSE2 four
+// rows at a time.
+//
+//   snake_query FILE [--columns A,B,...] [--where COLUMN=MIN:MAX]... [--group-by COLUMN] [--verify]
+//
+// e.g. snake_query telemetry.bin --where grid_width=20:30 --group-by agent --columns score,ticks
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/telemetry.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SNAKE_QUERY_SSE2
+#endif
+
+namespace
+{
+struct Filter
+{
+  size_t column;
+  double min, max;
+};
+
+struct QueryOptions
+{
+  std::string path;
+  std::vector<std::string> columns{"score", "length", "ticks"};
+  std::vector<std::pair<std::string, std::string>> where;  // column, "MIN:MAX"
+  std::string groupBy;
+  bool verify{false};
+};
+
+struct Aggregate
+{
+  double sum{0.0};
+  double min{std::numeric_limits<double>::infinity()};
+  double max{-std::numeric_limits<double>::infinity()};
+
+  void merge(double blockSum, double blockMin, double blockMax)
+  {
+    sum += blockSum;
+    min = std::min(min, blockMin);
+    max = std::max(max, blockMax);
+  }
+};
+
+struct Group
+{
+  uint64_t count{0};
+  std::vector<Aggregate> columns;
+};
+
+// Row masks are one 32-bit lane per row, all ones when the row is in, so they line up with
+// 32-bit columns; rows are padded to a multiple of 8 like the column arrays
+using Mask = std::vector<uint32_t>;
+
+/**
+ * Value of a row of a column, whatever its type.
+ */
+double valueAt(const void* column, ColumnType type, size_t row)
+{
+  switch (type)
+  {
+    case ColumnU8:
+      return static_cast<const uint8_t*>(column)[row];
+    case ColumnU16:
+      return static_cast<const uint16_t*>(column)[row];
+    case ColumnU32:
+      return static_cast<const uint32_t*>(column)[row];
+    case ColumnU64:
+      return static_cast<double>(static_cast<const uint64_t*>(column)[row]);
+    case ColumnF32:
+      return static_cast<const float*>(column)[row];
+  }
+  return 0.0;
+}
+
+/**
+ * Clears the mask for rows whose value is outside [min, max].
+ */
+void applyFilter(Mask& mask, const void* column, ColumnType type, size_t rows, double min, double max)
+{
+  size_t row{0};
+#if defined(SNAKE_QUERY_SSE2)
+  if (type == ColumnU32)
+  {
+    // No unsigned compares in SSE2: flip the sign bits and compare signed
+    const double low{std::max(std::ceil(min), 0.0)}, high{std::min(std::floor(max), 4294967295.0)};
+    if (low > high)
+    {
+      std::fill(mask.begin(), mask.end(), 0u);
+      return;
+    }
+    const __m128i bias{_mm_set1_epi32(INT32_MIN)};
+    const __m128i lowest{_mm_xor_si128(_mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(low))), bias)};
+    const __m128i highest{_mm_xor_si128(_mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(high))), bias)};
+    const auto* values{static_cast<const __m128i*>(column)};
+    for (; row + 4 <= mask.size(); row += 4)
+    {
+      const __m128i value{_mm_xor_si128(_mm_load_si128(values + row / 4), bias)};
+      const __m128i out{_mm_or_si128(_mm_cmplt_epi32(value, lowest), _mm_cmpgt_epi32(value, highest))};
+      auto* lanes{reinterpret_cast<__m128i*>(mask.data() + row)};
+      _mm_storeu_si128(lanes, _mm_andnot_si128(out, _mm_loadu_si128(lanes)));
+    }
+  }
+  else if (type == ColumnF32)
+  {
+    const __m128 lowest{_mm_set1_ps(static_cast<float>(min))}, highest{_mm_set1_ps(static_cast<float>(max))};
+    const auto* values{static_cast<const float*>(column)};
+    for (; row + 4 <= mask.size(); row += 4)
+    {
+      const __m128 value{_mm_load_ps(values + row)};
+      const __m128 in{_mm_and_ps(_mm_cmpge_ps(value, lowest), _mm_cmple_ps(value, highest))};
+      auto* lanes{reinterpret_cast<__m128i*>(mask.data() + row)};
+      _mm_storeu_si128(lanes, _mm_and_si128(_mm_castps_si128(in), _mm_loadu_si128(lanes)));
+    }
+  }
+#endif
+  for (; row < rows; ++row)
+  {
+    const double value{valueAt(column, type, row)};
+    if (value < min || value > max) mask[row] = 0;
+  }
+}
+
+/**
+ * Sum, min and max of a column over the rows in the mask; the mask must have at least one row.
+ */
+void aggregate(const Mask& mask, const void* column, ColumnType type, size_t rows, Aggregate& result)
+{
+#if defined(SNAKE_QUERY_SSE2)
+  if (type == ColumnU32)
+  {
+    // Masked-out rows add 0, and stand in as the highest value for min and the lowest for max
+    const __m128i bias{_mm_set1_epi32(INT32_MIN)};
+    const __m128i zero{_mm_setzero_si128()};
+    __m128i sum{zero};
+    __m128i min{_mm_set1_epi32(INT32_MAX)}, max{_mm_set1_epi32(INT32_MIN)};
+    const auto* values{static_cast<const __m128i*>(column)};
+    for (size_t row{0}; row + 4 <= mask.size(); row += 4)
+    {
+      const __m128i in{_mm_loadu_si128(reinterpret_cast<const __m128i*>(mask.data() + row))};
+      const __m128i value{_mm_and_si128(_mm_load_si128(values + row / 4), in)};
+      sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(value, zero));
+      sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(value, zero));
+
+      const __m128i flipped{_mm_xor_si128(value, bias)};
+      const __m128i forMin{_mm_or_si128(_mm_and_si128(in, flipped), _mm_andnot_si128(in, _mm_set1_epi32(INT32_MAX)))};
+      const __m128i forMax{_mm_or_si128(_mm_and_si128(in, flipped), _mm_andnot_si128(in, _mm_set1_epi32(INT32_MIN)))};
+      const __m128i lower{_mm_cmplt_epi32(forMin, min)}, higher{_mm_cmpgt_epi32(forMax, max)};
+      min = _mm_or_si128(_mm_and_si128(lower, forMin), _mm_andnot_si128(lower, min));
+      max = _mm_or_si128(_mm_and_si128(higher, forMax), _mm_andnot_si128(higher, max));
+    }
+
+    alignas(16) uint64_t sums[2];
+    alignas(16) int32_t mins[4], maxs[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(sums), sum);
+    _mm_store_si128(reinterpret_cast<__m128i*>(mins), min);
+    _mm_store_si128(reinterpret_cast<__m128i*>(maxs), max);
+    const auto unflip{[](int32_t value) { return static_cast<double>(static_cast<uint32_t>(value) ^ 0x80000000u); }};
+    result.merge(static_cast<double>(sums[0] + sums[1]), unflip(*std::min_element(mins, mins + 4)),
+                 unflip(*std::max_element(maxs, maxs + 4)));
+    return;
+  }
+#endif
+  double sum{0.0};
+  double min{std::numeric_limits<double>::infinity()}, max{-std::numeric_limits<double>::infinity()};
+  for (size_t row{0}; row < rows; ++row)
+  {
+    if (!mask[row]) continue;
+    const double value{valueAt(column, type, row)};
+    sum += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  result.merge(sum, min, max);
+}
+
+/**
+ * Rows left in the mask.
+ */
+uint64_t countRows(const Mask& mask)
+{
+  uint64_t count{0};
+  for (const uint32_t lane : mask) count += lane & 1;
+  return count;
+}
+
+QueryOptions parseOptions(int argc, char* argv[])
+{
+  QueryOptions options;
+  for (int i{1}; i < argc; ++i)
+  {
+    const std::string arg{argv[i]};
+    const bool hasValue{i + 1 < argc};
+
+    if (arg == "--columns" && hasValue)
+    {
+      options.columns.clear();
+      std::stringstream list(argv[++i]);
+      for (std::string column; std::getline(list, column, ',');)
+      {
+        if (!column.empty()) options.columns.push_back(column);
+      }
+    }
+    else if (arg == "--where" && hasValue)
+    {
+      const std::string filter{argv[++i]};
+      const size_t equals{filter.find('=')};
+      options.where.emplace_back(filter.substr(0, equals), equals == std::string::npos ? "" : filter.substr(equals + 1));
+    }
+    else if (arg == "--group-by" && hasValue)
+    {
+      options.groupBy = argv[++i];
+    }
+    else if (arg == "--verify")
+    {
+      options.verify = true;
+    }
+    else if (arg[0] != '-' && options.path.empty())
+    {
+      options.path = arg;
+    }
+    else
+    {
+      std::cout << "Usage: " << argv[0]
+                << " FILE [--columns A,B,...] [--where COLUMN=MIN:MAX]... [--group-by COLUMN] [--verify]\n";
+      exit(arg == "--help" ? 0 : 1);
+    }
+  }
+  if (options.path.empty())
+  {
+    std::cerr << "No telemetry file given" << std::endl;
+    exit(1);
+  }
+  return options;
+}
+
+/**
+ * Looks up a column by name, exiting if the file has none.
+ */
+size_t requireColumn(const TelemetryFile& file, const std::string& name)
+{
+  const int column{file.findColumn(name)};
+  if (column < 0)
+  {
+    std::cerr << "No column " << name << ", columns are:";
+    for (size_t i{0}; i < file.getColumnCount(); ++i) std::cerr << ' ' << file.getColumnName(i);
+    std::cerr << std::endl;
+    exit(1);
+  }
+  return static_cast<size_t>(column);
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  const QueryOptions options{parseOptions(argc, argv)};
+  const auto start{std::chrono::steady_clock::now()};
+
+  TelemetryFile file;
+  if (!file.open(options.path, options.verify)) return 1;
+
+  std::vector<size_t> columns;
+  for (const std::string& name : options.columns) columns.push_back(requireColumn(file, name));
+
+  // MIN or MAX may be left out, "score=100:" is 100 and up
+  std::vector<Filter> filters;
+  for (const auto& [name, range] : options.where)
+  {
+    const size_t colon{range.find(':')};
+    const std::string low{range.substr(0, colon)};
+    const std::string high{colon == std::string::npos ? low : range.substr(colon + 1)};
+    filters.push_back({requireColumn(file, name),
+                       low.empty() ? -std::numeric_limits<double>::infinity() : std::strtod(low.c_str(), nullptr),
+                       high.empty() ? std::numeric_limits<double>::infinity() : std::strtod(high.c_str(), nullptr)});
+  }
+
+  // Groups are the distinct values of an 8-bit column, one masked pass each
+  int groupColumn{-1};
+  if (!options.groupBy.empty())
+  {
+    groupColumn = static_cast<int>(requireColumn(file, options.groupBy));
+    if (file.getColumnType(groupColumn) != ColumnU8)
+    {
+      std::cerr << "Can only group by 8-bit columns" << std::endl;
+      return 1;
+    }
+  }
+
+  std::map<uint32_t, Group> groups;
+  size_t skipped{0};
+  Mask mask, groupMask;
+  for (const TelemetryFile::Block& block : file.getBlocks())
+  {
+    const bool excluded{std::any_of(filters.begin(), filters.end(),
+                                    [&block](const Filter& filter)
+                                    {
+                                      const ColumnStats& stats{block.stats[filter.column]};
+                                      return stats.max < filter.min || stats.min > filter.max;
+                                    })};
+    if (excluded || block.rows == 0)
+    {
+      ++skipped;
+      continue;
+    }
+
+    // Filters the whole block passes need no mask
+    mask.assign((block.rows + 7) / 8 * 8, 0u);
+    std::fill(mask.begin(), mask.begin() + block.rows, ~0u);
+    for (const Filter& filter : filters)
+    {
+      const ColumnStats& stats{block.stats[filter.column]};
+      if (stats.min >= filter.min && stats.max <= filter.max) continue;
+      applyFilter(mask, file.column(block, filter.column), file.getColumnType(filter.column), block.rows, filter.min,
+                  filter.max);
+    }
+
+    const uint32_t firstGroup{groupColumn < 0 ? 0u : static_cast<uint32_t>(block.stats[groupColumn].min)};
+    const uint32_t lastGroup{groupColumn < 0 ? 0u : static_cast<uint32_t>(block.stats[groupColumn].max)};
+    for (uint32_t value{firstGroup}; value <= lastGroup; ++value)
+    {
+      const Mask* rows{&mask};
+      if (groupColumn >= 0)
+      {
+        const auto* keys{static_cast<const uint8_t*>(file.column(block, groupColumn))};
+        groupMask = mask;
+        for (size_t row{0}; row < block.rows; ++row)
+        {
+          if (keys[row] != value) groupMask[row] = 0;
+        }
+        rows = &groupMask;
+      }
+
+      const uint64_t count{countRows(*rows)};
+      if (count == 0) continue;
+
+      Group& group{groups[value]};
+      group.columns.resize(columns.size());
+      group.count += count;
+      for (size_t i{0}; i < columns.size(); ++i)
+      {
+        aggregate(*rows, file.column(block, columns[i]), file.getColumnType(columns[i]), block.rows, group.columns[i]);
+      }
+    }
+  }
+
+  const double elapsed{std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()};
+  std::printf("%s: %zu games in %zu blocks, %zu blocks skipped", options.path.c_str(), file.getRows(),
+              file.getBlocks().size(), skipped);
+  if (file.getDamagedBlocks() > 0) std::printf(", %zu damaged blocks left out", file.getDamagedBlocks());
+  std::printf(", %.2f ms\n", elapsed);
+
+  for (const auto& [value, group] : groups)
+  {
+    if (groupColumn >= 0)
+    {
+      std::printf("\n%s = %u: %llu games\n", options.groupBy.c_str(), value, static_cast<unsigned long long>(group.count));
+    }
+    else
+    {
+      std::printf("\n%llu games\n", static_cast<unsigned long long>(group.count));
+    }
+    std::printf("  %-16s %14s %12s %12s %12s\n", "column", "sum", "mean", "min", "max");
+    for (size_t i{0}; i < columns.size(); ++i)
+    {
+      const Aggregate& column{group.columns[i]};
+      std::printf("  %-16s %14.0f %12.2f %12g %12g\n", options.columns[i].c_str(), column.sum,
+                  column.sum / static_cast<double>(group.count), column.min, column.max);
+    }
+  }
+  if (groups.empty()) std::printf("\nNo games match\n");
+  return 0;
+}